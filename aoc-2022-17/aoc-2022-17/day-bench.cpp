@@ -0,0 +1,14 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "test.cpp"
+
+#include "aoc-bench.h"
+
+// part 2 is the same call with a trillion rocks. Once the cycle turns up the rock count stops
+// mattering, so a bigger input here would only mean a longer wind pattern - no synthetic sizes
+void aoc_bench::registerDay() {
+	add("day2022-17/doTheThing/sample", [] { return doTheThing(2022, getSampleInput()); });
+	add("day2022-17/doTheThing2/sample", [] { return doTheThing(1000000000000, getSampleInput()); });
+	add("day2022-17/doTheThing/puzzle", [] { return doTheThing(2022, getPuzzleInput()); });
+	add("day2022-17/doTheThing2/puzzle", [] { return doTheThing(1000000000000, getPuzzleInput()); });
+}
@@ -1,9 +1,11 @@
 #include "pch.h"
 
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <deque>
-#include <format>
 #include <functional>
+#include <unordered_map>
 
 using namespace std;
 
@@ -231,52 +233,227 @@ v2 getStartingPos(const deque<Rock>& fallenRocks) {
 	}
 }
 
-int64_t doTheThing(int64_t numRocks, const std::string_view& puzzleInput) {
-	deque<Rock> fallenRocks;
-	vector<int64_t> loopPoints;     //how many rocks have fallen after puzzle input
-	vector<int64_t> loopPointTicks; //what tick we're on after rock falls 
-	int64_t tick = 0;
-	for (int64_t i = 0; i < numRocks; i++) {
-		const RockFlavor rockFlavor = static_cast<RockFlavor>(i % rockShapes.size());
-		auto [restPos, newtick] = rockFall(fallenRocks, puzzleInput, tick, rockFlavor, getStartingPos(fallenRocks));
-		fallenRocks.emplace_back(Rock{ rockFlavor, restPos, newtick });
-		if( newtick / std::ssize(puzzleInput) > tick / std::ssize(puzzleInput)) {
-			// search for loops
-			for( int loopIdx=0; loopIdx<std::ssize(loopPoints); loopIdx++ ) {
-				int64_t k = 0;
-				int64_t loopPoint = loopPoints[loopIdx];
-				const auto loopPointTick = loopPointTicks[loopIdx];
-				const auto rockFinishedOffset = loopPointTick % std::ssize(puzzleInput);
-				if (rockFinishedOffset != newtick % std::ssize(puzzleInput)) {
-					std::cout << std::format("No loop at {} with {}: tick offsets don't match\n", loopPoint, tick);
-					break;
-				}
-				for (k = 0; k < 20; k++) {
-					if ((fallenRocks[loopPoint - k -1].flavor != fallenRocks[std::ssize(fallenRocks) -1 - k].flavor) ||
-						(fallenRocks[loopPoint - k -1].pos.x != fallenRocks[std::ssize(fallenRocks) -1 -k].pos.x)) {
-						auto oldVertOffset = fallenRocks[loopPoint - k - 1].pos.y - fallenRocks[loopPoint - k - 2].pos.y;
-						auto newVertOffset = fallenRocks[std::ssize(fallenRocks) - k - 1].pos.y - fallenRocks[std::ssize(fallenRocks) - k - 2].pos.y;
-						if (oldVertOffset != newVertOffset) {
-							std::cout << "No loop at " << loopPoint << " with " << std::ssize(fallenRocks) << " because different at " << k << std::endl;
-							break;
-						}
-					}
-				}
-				if (k == 20) {
-					std::cout << "We might have found a loop! " << loopPoint << " with " << std::ssize(fallenRocks) << std::endl;
-					auto foundRock = qFindIf(fallenRocks, [modpoint = 1000000000000 % std::ssize(fallenRocks)](const Rock& rock) { return rock.tickCameToRest >= modpoint; });
-					std::cout << std::format("Offset rock for gigapoint: flavor {}, y {}\n", foundRock->flavor, foundRock->pos.y);
-					// what's the height at 1000000000000 
-					return 0;
+// The bitboard version of all of the above. The chamber is 7 wide, so a row fits in a byte with bit x
+// for column x, and no rock is taller than 4 so a whole rock fits in a uint32_t, one byte per row with
+// its bottom row in the low byte. A gust is then a shift (plus a check against the wall columns) and
+// "does it hit anything" is a single AND against the 4 chamber rows the rock overlaps.
+using RockMask = uint32_t;
+
+struct EncodedRock {
+	RockMask rows = 0;  // already shifted to x=2, where rocks appear
+	int64_t height = 0;
+};
+
+vector<EncodedRock> encodeRockShapes() {
+	vector<EncodedRock> encoded;
+	for (const auto& shape : rockShapes) {
+		EncodedRock rock{ 0, ssize(shape) };
+		for (int y = 0; y < ssize(shape); y++) {
+			for (int x = 0; x < ssize(shape[y]); x++) {
+				if (shape[y][x]) {
+					rock.rows |= RockMask{ 1 } << (y * 8 + x + 2);
 				}
 			}
-			loopPoints.push_back(fallenRocks.size());
-			loopPointTicks.push_back(newtick);
 		}
+		encoded.push_back(rock);
+	}
+	return encoded;
+}
+
+const vector<EncodedRock> encodedRocks = encodeRockShapes();
+
+class Chamber {
+public:
+	// Only the top rowsKept rows are remembered, in a ring buffer. Nothing falls anywhere near that far
+	// below the top of the tower, so the tower can grow forever in 4k of memory.
+	static constexpr int64_t rowsKept = 4096;
+
+	explicit Chamber(const std::string_view& windPattern) : mWind(windPattern), mRows(rowsKept + 4, 0) {
+		assert(!mWind.empty());
+	}
+
+	// drops a rock until it comes to rest, and returns its lower left corner like rockFall does
+	v2 dropRock(RockFlavor flavor) {
+		const auto& rock = encodedRocks[flavor];
+		RockMask rows = rock.rows;
+		int64_t x = 2;
+
+		// it appears 3 rows above the tower, so the first 4 gusts happen with nothing but walls around it
+		for (int i = 0; i < 4; i++) {
+			rows = gust(rows, x);
+		}
+		int64_t y = mTowerHeight;
+		while (y > 0 && !collides(rows, y - 1)) {
+			y--;
+			int64_t blownX = x;
+			const auto blown = gust(rows, blownX);
+			if (!collides(blown, y)) {
+				rows = blown;
+				x = blownX;
+			}
+		}
+		assert(y + rowsKept > mTowerHeight + 8);
+
+		for (int64_t row = 0; row < rock.height; row++) {
+			setRow(y + row, getRow(y + row) | static_cast<uint8_t>(rows >> (row * 8)));
+		}
+		const auto newHeight = std::max(mTowerHeight, y + rock.height);
+		// keep the rows a new rock can touch clear of whatever was there rowsKept rows ago
+		for (int64_t row = mTowerHeight + 8; row < newHeight + 8; row++) {
+			setRow(row, 0);
+		}
+		mTowerHeight = newHeight;
+		return v2{ x, y };
+	}
+
+	int64_t towerHeight() const { return mTowerHeight; }
+	int64_t tick() const { return mTick; }
+	int64_t windIndex() const { return mWindIdx; }
+
+	uint8_t getRow(const int64_t y) const { return mRows[y & (rowsKept - 1)]; }
+
+	// the top skylineRows rows of the tower packed 8 to a uint64_t, with the floor showing as a full row
+	static constexpr int64_t skylineRows = 32;
+	std::array<uint64_t, skylineRows / 8> skyline() const {
+		std::array<uint64_t, skylineRows / 8> packed{};
+		for (int64_t i = 0; i < skylineRows; i++) {
+			const auto y = mTowerHeight - 1 - i;
+			const uint64_t row = (y < 0) ? 0x7f : getRow(y);
+			packed[i / 8] |= row << (i % 8 * 8);
+		}
+		return packed;
+	}
+
+private:
+	static constexpr RockMask leftWall = 0x01010101;
+	static constexpr RockMask rightWall = 0x40404040;
+
+	// shifts the rock with the next gust unless it's up against a wall, x follows along
+	RockMask gust(const RockMask rows, int64_t& x) {
+		const bool left = mWind[mWindIdx] == '<';
+		mTick++;
+		mWindIdx = (mWindIdx + 1 == ssize(mWind)) ? 0 : mWindIdx + 1;
+		if (left) {
+			if (rows & leftWall) {
+				return rows;
+			}
+			x--;
+			return rows >> 1;
+		}
+		if (rows & rightWall) {
+			return rows;
+		}
+		x++;
+		return rows << 1;
+	}
+
+	bool collides(const RockMask rows, const int64_t y) const {
+		// the first 4 rows are mirrored past the end, so 4 rows starting anywhere are contiguous
+		const auto idx = y & (rowsKept - 1);
+		const RockMask chamberRows = RockMask{ mRows[idx] } | (RockMask{ mRows[idx + 1] } << 8) |
+			(RockMask{ mRows[idx + 2] } << 16) | (RockMask{ mRows[idx + 3] } << 24);
+		return (rows & chamberRows) != 0;
+	}
+
+	void setRow(const int64_t y, const uint8_t row) {
+		const auto idx = y & (rowsKept - 1);
+		mRows[idx] = row;
+		if (idx < 4) {
+			mRows[idx + rowsKept] = row;
+		}
+	}
+
+	std::string_view mWind;
+	int64_t mWindIdx = 0;
+	int64_t mTick = 0;
+	int64_t mTowerHeight = 0;
+	vector<uint8_t> mRows;
+};
+
+// Same as pex::CycleFinder. Feed it the state after every step, starting with the state after 0 steps,
+// along with the number you care about at that step. Once a state repeats, valueAt() can answer for
+// any step without simulating there, and growth per trip around the loop gets extrapolated.
+template <typename Key, typename Value = int64_t, typename Hash = std::hash<Key>>
+class CycleFinder {
+public:
+	// returns true once the cycle is found, after that there's no need to keep adding
+	bool add(const Key& key, const Value& value) {
+		if (found()) {
+			return true;
+		}
+		const int64_t step = std::ssize(mValues);
+		mValues.push_back(value);
+		const auto [firstSeen, inserted] = mFirstSeen.try_emplace(key, step);
+		if (!inserted) {
+			mCycleStart = firstSeen->second;
+			mCycleLength = step - mCycleStart;
+			mFirstSeen.clear();
+		}
+		return found();
+	}
+
+	bool found() const { return mCycleLength > 0; }
+	int64_t cycleStart() const { return mCycleStart; }
+	int64_t cycleLength() const { return mCycleLength; }
+
+	Value valueAt(const int64_t step) const {
+		if (step < std::ssize(mValues)) {
+			return mValues[step];
+		}
+		assert(found());
+		const int64_t loops = (step - mCycleStart) / mCycleLength;
+		const int64_t offset = (step - mCycleStart) % mCycleLength;
+		const Value growthPerLoop = mValues[mCycleStart + mCycleLength] - mValues[mCycleStart];
+		return mValues[mCycleStart + offset] + growthPerLoop * loops;
+	}
+
+private:
+	std::unordered_map<Key, int64_t, Hash> mFirstSeen;
+	std::vector<Value> mValues;
+	int64_t mCycleStart = 0;
+	int64_t mCycleLength = 0;
+};
+
+// Everything that decides where the next rocks end up: which rock is next, where we are in the wind,
+// and the shape of the top of the tower. 32 rows is plenty, nothing falls that far past the top.
+struct ChamberState {
+	int64_t nextFlavor = 0;
+	int64_t windIdx = 0;
+	std::array<uint64_t, Chamber::skylineRows / 8> skyline{};
+
+	bool operator==(const ChamberState&) const = default;
+};
+
+struct ChamberStateHash {
+	size_t operator()(const ChamberState& state) const {
+		size_t hash = std::hash<int64_t>{}(state.nextFlavor * 100003 + state.windIdx);
+		for (const auto rows : state.skyline) {
+			hash = hash * 1099511628211ull ^ std::hash<uint64_t>{}(rows);
+		}
+		return hash;
+	}
+};
+
+int64_t doTheThing(int64_t numRocks, const std::string_view& puzzleInput) {
+	Chamber chamber(puzzleInput);
+	CycleFinder<ChamberState, int64_t, ChamberStateHash> cycleFinder;
+	const auto numFlavors = std::ssize(rockShapes);
+	for (int64_t i = 0; i < numRocks; i++) {
+		if (cycleFinder.add(ChamberState{ i % numFlavors, chamber.windIndex(), chamber.skyline() }, chamber.towerHeight())) {
+			return cycleFinder.valueAt(numRocks);
+		}
+		chamber.dropRock(static_cast<RockFlavor>(i % numFlavors));
+	}
+	return chamber.towerHeight();
+}
 
-		tick = newtick;
+// no shortcuts, for checking the shortcut
+int64_t towerHeightBruteForce(int64_t numRocks, const std::string_view& puzzleInput) {
+	Chamber chamber(puzzleInput);
+	for (int64_t i = 0; i < numRocks; i++) {
+		chamber.dropRock(static_cast<RockFlavor>(i % rockShapes.size()));
 	}
-	return getHighestRockY(fallenRocks);
+	return chamber.towerHeight();
 }
 
 
@@ -368,6 +545,62 @@ TEST(rocks, rock12IntersetionTests) {
 }
 
 
+// the deque version above is slow but it's what the first star was earned with, so the bitboard has to agree
+TEST(rocks, bitboard_matchesDequeRestingPositions) {
+	for (const auto& windPattern : { getSampleInput(), getPuzzleInput() }) {
+		Chamber chamber(windPattern);
+		deque<Rock> fallenRocks;
+		int64_t tick = 0;
+		for (int64_t i = 0; i < 3000; i++) {
+			const RockFlavor flavor = static_cast<RockFlavor>(i % rockShapes.size());
+			const auto [restPos, newtick] = rockFall(fallenRocks, windPattern, tick, flavor, getStartingPos(fallenRocks));
+			fallenRocks.emplace_back(Rock{ flavor, restPos, newtick });
+			tick = newtick;
+			ASSERT_EQ(restPos, chamber.dropRock(flavor));
+			ASSERT_EQ(tick, chamber.tick());
+		}
+		EXPECT_EQ(getHighestRockY(fallenRocks), chamber.towerHeight());
+	}
+}
+
+TEST(rocks, bitboard_sample_3068) {
+	Chamber chamber(getSampleInput());
+	for (int64_t i = 0; i < 2022; i++) {
+		chamber.dropRock(static_cast<RockFlavor>(i % rockShapes.size()));
+	}
+	EXPECT_EQ(3068, chamber.towerHeight());
+}
+
+// the tower ends up far taller than the ring buffer, so rows get recycled many times over
+TEST(rocks, bitboard_ringBufferRecyclesRows) {
+	Chamber chamber(getPuzzleInput());
+	for (int64_t i = 0; i < 100000; i++) {
+		chamber.dropRock(static_cast<RockFlavor>(i % rockShapes.size()));
+	}
+	EXPECT_GT(chamber.towerHeight(), 10 * Chamber::rowsKept);
+	for (int64_t y = chamber.towerHeight(); y < chamber.towerHeight() + 8; y++) {
+		EXPECT_EQ(0, chamber.getRow(y));
+	}
+	EXPECT_NE(0, chamber.getRow(chamber.towerHeight() - 1));
+}
+
+TEST(rocks, cycleFinder_matchesBruteForce) {
+	for (const auto& windPattern : { getSampleInput(), getPuzzleInput() }) {
+		for (const int64_t numRocks : { 1, 5, 2022, 12345, 1000000 }) {
+			EXPECT_EQ(towerHeightBruteForce(numRocks, windPattern), doTheThing(numRocks, windPattern));
+		}
+	}
+}
+
+TEST(rocks, sample_partTwo) {
+	EXPECT_EQ(1514285714288, doTheThing(1000000000000, getSampleInput()));
+}
+
+TEST(rocks, partTwo) {
+	EXPECT_EQ(1541449275365, doTheThing(1000000000000, getPuzzleInput()));
+}
+
+// checked against towerHeightBruteForce once, which takes the better part of a minute
 TEST(rocks, zPartTwo) {
-	EXPECT_EQ(0, doTheThing(1000000000, getPuzzleInput()));
+	EXPECT_EQ(1541449274, doTheThing(1000000000, getPuzzleInput()));
 }
@@ -0,0 +1,12 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "test.cpp"
+
+#include "aoc-bench.h"
+
+// part 2 (countInside) never got finished, so only part 1 is here. A tiled maze is lots of
+// separate loops and only the one through S gets walked, so there are no synthetic sizes either
+void aoc_bench::registerDay() {
+	add("day10/doTheThing/sample", [] { return doTheThing(sampleInput2); });
+	add("day10/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+}
@@ -0,0 +1,21 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "test.cpp"
+
+#include "aoc-bench.h"
+
+void aoc_bench::registerDay() {
+	add("day11/doTheThing/sample", [] { return doTheThing(sampleInput); });
+	add("day11/doTheThing2/sample", [] { return doTheThing2(sampleInput, 1000000); });
+	add("day11/doTheThing/puzzle", [] { return doTheThing(puzzleInput1); });
+	add("day11/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput1, 1000000); });
+	// every galaxy pair gets summed, so x100 would be 10^9 pairs - the universe only goes to x10
+	for (const auto& [scale, suffix] : scales) {
+		if (scale <= 10) {
+			const auto tiles = tilesFor(scale);
+			const auto scaled = tileGrid(puzzleInput1, tiles, tiles);
+			add(std::string("day11/doTheThing/") + suffix, [scaled] { return doTheThing(scaled); });
+			add(std::string("day11/doTheThing2/") + suffix, [scaled] { return doTheThing2(scaled, 1000000); });
+		}
+	}
+}
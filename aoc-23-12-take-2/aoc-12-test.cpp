@@ -87,7 +87,7 @@ int64_t _findArrangementsDP(
 
 	auto dpGrid = createGrid<int64_t>(pattern.size()+1, groups.size()+1, 0);
 	// there's always 1 way to fit the pattern when you have 0 groups
-	dpGrid[0] = std::vector<int64_t>(pattern.size() + 1, 1);
+	std::ranges::fill(dpGrid[0], 1);
 
 	// begin with last group at end of pattern
 	for (int64_t groupSlice = 1; groupSlice <= std::ssize(groups); ++groupSlice) {
@@ -0,0 +1,21 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include <cmath>
+
+#include "aoc-12-test.cpp"
+
+#include "aoc-bench.h"
+
+// findArrangements2 prints its tables, hence quietly(). doTheThing2 is seconds a go already,
+// so it stops at x10
+void aoc_bench::registerDay() {
+	add("day12/doTheThing/puzzle", [] { return quietly([] { return doTheThing(puzzleInput); }); });
+	add("day12/doTheThing2/puzzle", [] { return quietly([] { return doTheThing2(puzzleInput); }); });
+	for (const auto& [scale, suffix] : scales) {
+		const auto scaled = repeatVector(puzzleInput, scale);
+		add(std::string("day12/doTheThing/") + suffix, [scaled] { return quietly([&scaled] { return doTheThing(scaled); }); });
+		if (scale <= 10) {
+			add(std::string("day12/doTheThing2/") + suffix, [scaled] { return quietly([&scaled] { return doTheThing2(scaled); }); });
+		}
+	}
+}
@@ -9,12 +9,36 @@
 // and ergonomic in that they operate on whole containers instead of begin-end blocks
 
 #include <algorithm>
+#include <cassert>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <numeric>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace pex {
 	// have I gone crazy? or is it the world around me
 	#define cauto const auto
@@ -130,6 +154,82 @@ namespace pex {
 		return result;
 	}
 
+	// pSplit's lazy cousin: iterating it hands out string_views straight into str, so there's no
+	// stringstream, no string per token and no vector to hold them - str just has to outlive it.
+	// otherwise same rules as pSplit, e.g. a trailing delimiter doesn't make an empty last token
+	template <typename Delim>
+	class SplitRange {
+	public:
+		class iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = const std::string_view&;
+
+			iterator() = default;
+			iterator(const std::string_view str, const Delim delim) : mRest(str), mDelim(delim), mDone(false) { ++(*this); }
+
+			reference operator*() const { return mToken; }
+			pointer operator->() const { return &mToken; }
+
+			iterator& operator++() {
+				if (mRest.empty()) {
+					mDone = true;
+					return *this;
+				}
+				const auto pos = mRest.find(mDelim);
+				mToken = mRest.substr(0, pos);
+				mRest = (pos == std::string_view::npos) ? std::string_view() : mRest.substr(pos + delimSize());
+				return *this;
+			}
+
+			iterator operator++(int) {
+				iterator old = *this;
+				++(*this);
+				return old;
+			}
+
+			bool operator==(const iterator& rhs) const {
+				return mDone == rhs.mDone && (mDone || mToken.data() == rhs.mToken.data());
+			}
+
+		private:
+			size_t delimSize() const {
+				if constexpr (std::is_same_v<Delim, char>) {
+					return 1;
+				}
+				else {
+					return mDelim.size();
+				}
+			}
+
+			std::string_view mToken;
+			std::string_view mRest;
+			Delim mDelim{};
+			bool mDone = true;
+		};
+
+		SplitRange(const std::string_view str, const Delim delim) : mStr(str), mDelim(delim) {}
+
+		iterator begin() const { return iterator(mStr, mDelim); }
+		iterator end() const { return iterator(); }
+
+	private:
+		std::string_view mStr;
+		Delim mDelim;
+	};
+
+	SplitRange<char> pSplitView(const std::string_view str, const char delim) {
+		return { str, delim };
+	}
+
+	SplitRange<std::string_view> pSplitView(const std::string_view str, const std::string_view delim) {
+		assert(!delim.empty());
+		return { str, delim };
+	}
+
 	template <typename T> int sgn(T val) {
 		return (T(0) < val) - (val < T(0));
 	}
@@ -240,83 +340,427 @@ std::ostream& operator<<(std::ostream& os, const Vec3<T>& v3) {
 	return os;
 }
 
+// Grid used to be a vector of vectors, which meant one heap allocation per row and two dependent
+// loads for every grid[y][x]. Now it's a single row-major allocation where each row is padded out
+// to a cache line multiple (the stride), and grid[y] hands back a span over that row so all the
+// grid[y][x] code out there keeps working. Iterating a Grid walks its rows as spans.
 template <typename T>
-using Grid = std::vector<std::vector<T>>;
+class Grid {
+public:
+	static constexpr int64_t cacheLineBytes = 64;
+
+	template <typename Cell>
+	class RowIterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+		using value_type = std::span<Cell>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::span<Cell>;
+
+		RowIterator() = default;
+		RowIterator(Cell* row, const int64_t width, const int64_t stride) : mRow(row), mWidth(width), mStride(stride) {}
+
+		std::span<Cell> operator*() const { return { mRow, static_cast<size_t>(mWidth) }; }
+		RowIterator& operator++() { mRow += mStride; return *this; }
+		RowIterator operator++(int) { RowIterator old = *this; mRow += mStride; return old; }
+		bool operator==(const RowIterator& rhs) const { return mRow == rhs.mRow; }
+
+	private:
+		Cell* mRow = nullptr;
+		int64_t mWidth = 0;
+		int64_t mStride = 0;
+	};
+
+	using iterator = RowIterator<T>;
+	using const_iterator = RowIterator<const T>;
+
+	Grid() = default;
+
+	Grid(const int64_t width, const int64_t height, const T& initVal = T())
+		: mWidth(width), mHeight(height), mStride(paddedStride(width)), mCells(allocate(mStride * height)) {
+		std::uninitialized_fill_n(mCells.get(), mStride * mHeight, initVal);
+	}
+
+	// mostly so tests can spell out little grids inline
+	Grid(std::initializer_list<std::initializer_list<T>> rows)
+		: Grid(rows.size() ? std::ssize(*rows.begin()) : 0, std::ssize(rows)) {
+		int64_t y = 0;
+		for (cauto& row : rows) {
+			assert(std::ssize(row) == mWidth);
+			std::copy(row.begin(), row.end(), (*this)[y++].begin());
+		}
+	}
 
-// turn a typical AoC map input into a 2d vector array
+	Grid(const Grid& other)
+		: mWidth(other.mWidth), mHeight(other.mHeight), mStride(other.mStride), mCells(allocate(other.mStride * other.mHeight)) {
+		std::uninitialized_copy_n(other.mCells.get(), mStride * mHeight, mCells.get());
+	}
+
+	Grid(Grid&& other) noexcept
+		: mWidth(std::exchange(other.mWidth, 0)),
+		mHeight(std::exchange(other.mHeight, 0)),
+		mStride(std::exchange(other.mStride, 0)),
+		mCells(std::move(other.mCells)) {}
+
+	Grid& operator=(const Grid& other) {
+		if (this != &other) {
+			*this = Grid(other);
+		}
+		return *this;
+	}
+
+	Grid& operator=(Grid&& other) noexcept {
+		mWidth = std::exchange(other.mWidth, 0);
+		mHeight = std::exchange(other.mHeight, 0);
+		mStride = std::exchange(other.mStride, 0);
+		mCells = std::move(other.mCells);
+		return *this;
+	}
+
+	std::span<T> operator[](const int64_t y) { return { mCells.get() + y * mStride, static_cast<size_t>(mWidth) }; }
+	std::span<const T> operator[](const int64_t y) const { return { mCells.get() + y * mStride, static_cast<size_t>(mWidth) }; }
+
+	// rows, not cells, so std::ssize(grid) still means height
+	size_t size() const { return static_cast<size_t>(mHeight); }
+	int64_t width() const { return mWidth; }
+	int64_t height() const { return mHeight; }
+	int64_t stride() const { return mStride; }
+
+	// raw row-major storage, padding included; cell x,y lives at data()[y * stride() + x]
+	T* data() { return mCells.get(); }
+	const T* data() const { return mCells.get(); }
+
+	iterator begin() { return { mCells.get(), mWidth, mStride }; }
+	iterator end() { return { mCells.get() + mHeight * mStride, mWidth, mStride }; }
+	const_iterator begin() const { return { mCells.get(), mWidth, mStride }; }
+	const_iterator end() const { return { mCells.get() + mHeight * mStride, mWidth, mStride }; }
+
+	// padding is never compared, it's just dead space
+	bool operator==(const Grid& rhs) const {
+		if (mWidth != rhs.mWidth || mHeight != rhs.mHeight) {
+			return false;
+		}
+		for (int64_t y = 0; y < mHeight; y++) {
+			if (!std::equal((*this)[y].begin(), (*this)[y].end(), rhs[y].begin())) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	struct Deleter {
+		int64_t count = 0;
+		void operator()(T* cells) const {
+			std::destroy_n(cells, count);
+			::operator delete(cells, std::align_val_t{ cacheLineBytes });
+		}
+	};
+
+	// pad rows out to whole cache lines when the cell type packs evenly into one. an even number of
+	// lines per row makes a column walk keep landing in the same few cache sets (power of two widths
+	// are the worst), so those get one more line to knock them out of step
+	static int64_t paddedStride(const int64_t width) {
+		if (cacheLineBytes % sizeof(T) != 0) {
+			return width;
+		}
+		cauto cellsPerLine = cacheLineBytes / static_cast<int64_t>(sizeof(T));
+		cauto stride = (width + cellsPerLine - 1) / cellsPerLine * cellsPerLine;
+		return (stride / cellsPerLine) % 2 == 0 ? stride + cellsPerLine : stride;
+	}
+
+	static std::unique_ptr<T[], Deleter> allocate(const int64_t count) {
+		if (count == 0) {
+			return {};
+		}
+		auto cells = static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ cacheLineBytes }));
+		return { cells, Deleter{ count } };
+	}
+
+	int64_t mWidth = 0;
+	int64_t mHeight = 0;
+	int64_t mStride = 0;
+	std::unique_ptr<T[], Deleter> mCells;
+};
+
+// read-only, non-owning look at a grid living in somebody else's memory - usually the raw input
+// text itself, where every row is followed by its newline so the stride is width+1 (or +2 for \r\n)
 template <typename T>
-Grid<T> parseGrid(const std::string& input) {
-	cauto rows = pex::pSplit(input, '\n');
-	Grid<T> grid;
-	int64_t lastwidth=0; // for debugging/checking
-	for (cauto& row : rows) {
-		std::vector<char> newRow;
-		for (int x = 0; x < row.size(); x++) {
-			newRow.emplace_back(row[x]);
+class GridView {
+public:
+	using const_iterator = typename Grid<T>::const_iterator;
+
+	GridView() = default;
+	GridView(const T* cells, const int64_t width, const int64_t height, const int64_t stride)
+		: mCells(cells), mWidth(width), mHeight(height), mStride(stride) {}
+
+	std::span<const T> operator[](const int64_t y) const { return { mCells + y * mStride, static_cast<size_t>(mWidth) }; }
+
+	size_t size() const { return static_cast<size_t>(mHeight); }
+	int64_t width() const { return mWidth; }
+	int64_t height() const { return mHeight; }
+	int64_t stride() const { return mStride; }
+	const T* data() const { return mCells; }
+
+	const_iterator begin() const { return { mCells, mWidth, mStride }; }
+	const_iterator end() const { return { mCells + mHeight * mStride, mWidth, mStride }; }
+
+private:
+	const T* mCells = nullptr;
+	int64_t mWidth = 0;
+	int64_t mHeight = 0;
+	int64_t mStride = 0;
+};
+
+// zero-copy: finds where the rows are and checks they're all the same width without moving a byte.
+// a missing newline on the last row is fine; ragged rows give you nullopt
+std::optional<GridView<char>> gridView(const std::string_view text) {
+	cauto firstBreak = text.find('\n');
+	if (firstBreak == std::string_view::npos) {
+		return GridView<char>(text.data(), std::ssize(text), text.empty() ? 0 : 1, std::ssize(text));
+	}
+	cauto newline = (firstBreak > 0 && text[firstBreak - 1] == '\r') ? std::string_view("\r\n") : std::string_view("\n");
+	cauto width = static_cast<int64_t>(firstBreak + 1 - newline.size());
+	cauto stride = static_cast<int64_t>(firstBreak + 1);
+	cauto paddedSize = std::ssize(text) + (text.back() == '\n' ? 0 : std::ssize(newline));
+	if (paddedSize % stride != 0) {
+		return std::nullopt;
+	}
+	cauto height = paddedSize / stride;
+	for (int64_t y = 0; y < height; y++) {
+		cauto row = text.substr(y * stride, stride);
+		cauto terminator = row.substr(width);
+		if (row.substr(0, width).find('\n') != std::string_view::npos) {
+			return std::nullopt;
+		}
+		if (terminator != newline && !(y == height - 1 && terminator.empty())) {
+			return std::nullopt;
+		}
+	}
+	return GridView<char>(text.data(), width, height, stride);
+}
+
+// read-only memory map of a whole file, unmapped when it goes away
+class MappedFile {
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept
+		: mBytes(std::exchange(other.mBytes, nullptr)), mSize(std::exchange(other.mSize, 0)) {}
+	MappedFile& operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			mBytes = std::exchange(other.mBytes, nullptr);
+			mSize = std::exchange(other.mSize, 0);
+		}
+		return *this;
+	}
+	~MappedFile() { unmap(); }
+
+	static std::optional<MappedFile> open(const std::string& path) {
+		MappedFile mapped;
+#ifdef _WIN32
+		cauto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return std::nullopt;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			return std::nullopt;
+		}
+		if (size.QuadPart > 0) {
+			cauto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping) {
+				mapped.mBytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+			if (!mapped.mBytes) {
+				CloseHandle(file);
+				return std::nullopt;
+			}
+			mapped.mSize = size.QuadPart;
+		}
+		CloseHandle(file);
+#else
+		cauto fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return std::nullopt;
+		}
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			close(fd);
+			return std::nullopt;
+		}
+		if (info.st_size > 0) {
+			cauto bytes = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (bytes == MAP_FAILED) {
+				close(fd);
+				return std::nullopt;
+			}
+			mapped.mBytes = static_cast<const char*>(bytes);
+			mapped.mSize = info.st_size;
+		}
+		close(fd);
+#endif
+		return mapped;
+	}
+
+	std::string_view text() const { return { mBytes, static_cast<size_t>(mSize) }; }
+
+private:
+	void unmap() {
+		if (mBytes) {
+#ifdef _WIN32
+			UnmapViewOfFile(mBytes);
+#else
+			munmap(const_cast<char*>(mBytes), mSize);
+#endif
+			mBytes = nullptr;
+			mSize = 0;
 		}
-		assert((lastwidth==0)||(newRow.size() == lastwidth));
-		lastwidth = newRow.size();
-		grid.emplace_back(newRow);
+	}
+
+	const char* mBytes = nullptr;
+	int64_t mSize = 0;
+};
+
+// the zero-copy way in for big maps. grid points straight at the mapped bytes, so it's only good
+// for as long as file is
+struct MappedGrid {
+	MappedFile file;
+	GridView<char> grid;
+};
+
+std::optional<MappedGrid> mapGridFile(const std::string& path) {
+	auto file = MappedFile::open(path);
+	if (!file) {
+		return std::nullopt;
+	}
+	cauto view = gridView(file->text());
+	if (!view) {
+		return std::nullopt;
+	}
+	return MappedGrid{ std::move(*file), *view };
+}
+
+template <typename T>
+int64_t gridHeight(const GridView<T>& grid) {
+	return grid.height();
+}
+
+template <typename T>
+int64_t gridWidth(const GridView<T>& grid) {
+	return grid.width();
+}
+
+template <typename T>
+bool inBounds(const GridView<T>& grid, const Vec2& point) {
+	return((point.x >= 0)
+			&& (point.y >= 0)
+			&& (point.y < grid.height())
+			&& (point.x < grid.width()));
+}
+
+// this is the one place a view gets copied - when the cells need to turn into something else
+template<typename T2, typename T1, typename UnaryOperation>
+[[nodiscard]] Grid<T2> gridTransform(const GridView<T1>& c, const UnaryOperation unaryOp) {
+	Grid<T2> newGrid(c.width(), c.height());
+	for (int64_t y = 0; y < c.height(); y++) {
+		std::transform(c[y].begin(), c[y].end(), newGrid[y].begin(), unaryOp);
+	}
+	return newGrid;
+}
+
+// turn a typical AoC map input into a 2d grid, converting each cell on the way in.
+// ragged rows can't be a view, so they get copied a row at a time instead: the grid is as wide as the
+// longest row and the short ones are padded out with T()
+template <typename T, typename UnaryOperation>
+Grid<T> parseGrid(const std::string_view input, const UnaryOperation unaryOp) {
+	if (cauto view = gridView(input)) {
+		return gridTransform<T>(*view, unaryOp);
+	}
+	std::vector<std::string_view> rows;
+	for (std::string_view rest = input; !rest.empty();) {
+		cauto end = rest.find('\n');
+		auto row = rest.substr(0, end);
+		if (!row.empty() && row.back() == '\r') {
+			row.remove_suffix(1);
+		}
+		rows.push_back(row);
+		rest = (end == std::string_view::npos) ? std::string_view() : rest.substr(end + 1);
+	}
+	int64_t width = 0;
+	for (cauto& row : rows) {
+		width = std::max(width, static_cast<int64_t>(row.size()));
+	}
+	Grid<T> grid(width, static_cast<int64_t>(rows.size()));
+	for (int64_t y = 0; y < static_cast<int64_t>(rows.size()); y++) {
+		std::transform(rows[y].begin(), rows[y].end(), grid[y].begin(), unaryOp);
 	}
 	return grid;
 }
 
+template <typename T>
+Grid<T> parseGrid(const std::string_view input) {
+	return parseGrid<T>(input, [](const char cell) { return static_cast<T>(cell); });
+}
+
 template <typename T>
 Grid<T> createGrid(int64_t width, int64_t height, T initVal = T(0)) {
-	Grid<T> result(height);
-	for (auto& row : result) {
-		row.resize(width, initVal);
-	}
-	return result;
+	return Grid<T>(width, height, initVal);
 }
 
 template <typename T>
 bool inBounds(const Grid<T>& grid, const T x, const T y) {
 	return((x >= 0)
 		&& (y >= 0)
-		&& (y < std::ssize(grid))
-		&& (x < std::ssize(grid[y])));
+		&& (y < grid.height())
+		&& (x < grid.width()));
 }
 
 template <typename T>
 bool inBounds(const Grid<T>& grid, const Vec2& point) {
 	return((point.x >= 0)
 			&& (point.y >= 0)
-			&& (point.y < std::ssize(grid))
-			&& (point.x < std::ssize(grid[point.y])));
+			&& (point.y < grid.height())
+			&& (point.x < grid.width()));
 }
 
 template <typename T>
 int64_t gridReduce(const Grid<T>& grid, const std::function<int64_t(const T cell)>& predicate) {
-	return pex::pReduce(grid, [&predicate](const int64_t acc, cauto& row) {
-		return pex::pReduce(row, acc, predicate);
-		});
+	int64_t acc = 0;
+	for (cauto& row : grid) {
+		for (cauto& cell : row) {
+			acc += predicate(cell);
+		}
+	}
+	return acc;
 }
 
 // seems like there must be a way to make this deduce everything - 
 // I tried playing around with -> declspec(unaryOp()) with no luck...
 template<typename T2, typename T1, typename UnaryOperation>
 [[nodiscard]] Grid<T2> gridTransform(const Grid<T1>& c, const UnaryOperation unaryOp) {
-	Grid<T2> newGrid;
-	for (cauto& row : c) {
-		std::vector<T2> newRow;
-		for (cauto& cell : row) {
-			newRow.emplace_back(unaryOp(cell));
-		}
-		newGrid.emplace_back(newRow);
+	Grid<T2> newGrid(c.width(), c.height());
+	for (int64_t y = 0; y < c.height(); y++) {
+		std::transform(c[y].begin(), c[y].end(), newGrid[y].begin(), unaryOp);
 	}
 	return newGrid;
 }
 
 template <typename T>
 int64_t gridHeight(const Grid<T>& grid) {
-	return grid.size();
+	return grid.height();
 }
 
 
 template <typename T>
 int64_t gridWidth(const Grid<T>& grid) {
-	return grid[0].size();
+	return grid.width();
 }
 
 template <typename T>
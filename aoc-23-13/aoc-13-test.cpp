@@ -12,10 +12,9 @@ using Map = std::vector<Row>;
 using Maps = std::vector<Map>;
 
 Maps parseInput(const std::string& input) {
-	auto lines = pSplit(input, '\n');
 	Maps maps;
 	Map curmap;
-	for (auto& line : lines) {		
+	for (const auto& line : pSplitView(input, '\n')) {
 		if (line.empty()) {
 			maps.emplace_back(curmap);
 			curmap = {};
@@ -0,0 +1,18 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-13-test.cpp"
+
+#include "aoc-bench.h"
+
+void aoc_bench::registerDay() {
+	add("day13/doTheThing/sample", [] { return doTheThing(sampleData); });
+	add("day13/doTheThing2/sample", [] { return doTheThing2(sampleData); });
+	add("day13/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+	add("day13/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput); });
+	for (const auto& [scale, suffix] : scales) {
+		// more mirrors, blank line between each
+		const auto scaled = repeatRecords(puzzleInput, "\n\n", scale) + "\n";
+		add(std::string("day13/doTheThing/") + suffix, [scaled] { return doTheThing(scaled); });
+		add(std::string("day13/doTheThing2/") + suffix, [scaled] { return doTheThing2(scaled); });
+	}
+}
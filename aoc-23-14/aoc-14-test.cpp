@@ -1,11 +1,14 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <format>
 #include <iterator>
 #include <queue>
 #include <optional>
 #include <regex>
+#include <span>
 #include <variant>
 
 #include "pex.h"
@@ -23,9 +26,8 @@ enum class Cell: int8_t {
 using Map = std::vector<std::vector<Cell>>;
 
 Map parseMap(const std::string& input) {
-    const auto rows = pSplit(input, '\n');
     Map map;
-    for( const auto& row: rows) {
+    for( const auto& row: pSplitView(input, '\n')) {
         std::vector<Cell> newRow;
         for(int x=0;x<row.size();x++) {
             newRow.emplace_back(row[x]=='.'?Cell::Space:
@@ -182,27 +184,203 @@ Map doCycle(const Map& lastmap, int64_t steps) {
     return newMap;
 }
 
-int64_t doTheThing2(const std::string& input) {
-    std::vector<Map> mapHistory;
-    mapHistory.emplace_back(parseMap(input));
-    for(;;) {
-        auto newMap = doCycle(mapHistory.back(),4);
-        for (auto mapIt = mapHistory.begin(); mapIt != mapHistory.end();mapIt++) {
-            if (*mapIt == newMap) {
-                // found loop point
-                int64_t loopSize = std::distance(mapIt, mapHistory.end());
-                int64_t loopStart = std::distance(mapHistory.begin(), mapIt);
-                // where do we land in future loop?
-                int64_t loopMod = (1000000000 - loopStart) % loopSize;
-                Map finalMap = newMap;
-                for (int i = 0; i < loopMod; i++) {
-                    finalMap = doCycle(finalMap, 4);
+// The fast version. Round rocks are one bit per cell, a line (row or column) at a time, and tilting a
+// line doesn't move rocks one by one: the cube rocks split each line into segments, and all a tilt does
+// to a segment is pile popcount(segment) rocks up at one end. North and south tilts work on a transposed
+// copy so that every tilt is along a line of bits.
+class SpinPlatform {
+public:
+    explicit SpinPlatform(const Map& map)
+        : mWidth(std::ssize(map[0])), mHeight(std::ssize(map)),
+          mRows(mHeight, mWidth), mCols(mWidth, mHeight),
+          mRowSegments(mHeight), mColSegments(mWidth), mZobristPrefix(mHeight) {
+        uint64_t seed = 0x5eed5eed5eed5eedull;
+        for (int64_t y = 0; y < mHeight; y++) {
+            mZobristPrefix[y].push_back(0);
+            for (int64_t x = 0; x < mWidth; x++) {
+                mZobristPrefix[y].push_back(mZobristPrefix[y].back() ^ splitMix64(seed));
+                if (map[y][x] == Cell::RoundRock) {
+                    mRows.set(y, x);
+                    mHash ^= mZobristPrefix[y][x] ^ mZobristPrefix[y][x + 1];
+                }
+            }
+        }
+        const auto addSegments = [&](std::vector<std::vector<Segment>>& segments, const int64_t lines,
+            const int64_t lineLength, const auto& isCube) {
+            for (int64_t line = 0; line < lines; line++) {
+                int64_t start = 0;
+                for (int64_t i = 0; i <= lineLength; i++) {
+                    if (i == lineLength || isCube(line, i)) {
+                        if (i > start) {
+                            segments[line].push_back({ start, i });
+                        }
+                        start = i + 1;
+                    }
+                }
+            }
+        };
+        addSegments(mRowSegments, mHeight, mWidth, [&](const int64_t y, const int64_t x) { return map[y][x] == Cell::CubeRock; });
+        addSegments(mColSegments, mWidth, mHeight, [&](const int64_t x, const int64_t y) { return map[y][x] == Cell::CubeRock; });
+    }
+
+    // north, west, south, east, same as doCycle(map, 4)
+    void spinCycle() {
+        transpose(mRows, mCols);
+        tilt(mCols, mColSegments, true);
+        transpose(mCols, mRows);
+        tilt(mRows, mRowSegments, true);
+        transpose(mRows, mCols);
+        tilt(mCols, mColSegments, false);
+        transpose(mCols, mRows);
+        mHash = 0;
+        tilt(mRows, mRowSegments, false, &mHash);
+    }
+
+    // Zobrist hash of where the round rocks are. Two different states can share a hash, but with
+    // 64 bits it's not going to happen to us
+    uint64_t hash() const { return mHash; }
+
+    int64_t northLoad() const {
+        int64_t load = 0;
+        for (int64_t y = 0; y < mHeight; y++) {
+            for (const auto word : mRows.line(y)) {
+                load += std::popcount(word) * (mHeight - y);
+            }
+        }
+        return load;
+    }
+
+    Map toMap() const {
+        Map map(mHeight, std::vector<Cell>(mWidth, Cell::CubeRock));
+        for (int64_t y = 0; y < mHeight; y++) {
+            for (const auto& segment : mRowSegments[y]) {
+                for (int64_t x = segment.start; x < segment.end; x++) {
+                    map[y][x] = mRows.test(y, x) ? Cell::RoundRock : Cell::Space;
+                }
+            }
+        }
+        return map;
+    }
+
+private:
+    struct Segment {
+        int64_t start;
+        int64_t end;
+    };
+
+    // lines of bits, each line padded out to whole words
+    struct BitLines {
+        BitLines(const int64_t lines, const int64_t lineLength)
+            : lineCount(lines), wordsPerLine((lineLength + 63) / 64), words(lines * wordsPerLine, 0) {}
+
+        std::span<uint64_t> line(const int64_t l) { return { words.data() + l * wordsPerLine, static_cast<size_t>(wordsPerLine) }; }
+        std::span<const uint64_t> line(const int64_t l) const { return { words.data() + l * wordsPerLine, static_cast<size_t>(wordsPerLine) }; }
+        bool test(const int64_t l, const int64_t i) const { return (words[l * wordsPerLine + i / 64] >> (i % 64)) & 1; }
+        void set(const int64_t l, const int64_t i) { words[l * wordsPerLine + i / 64] |= uint64_t{ 1 } << (i % 64); }
+
+        int64_t lineCount;
+        int64_t wordsPerLine;
+        std::vector<uint64_t> words;
+    };
+
+    static uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // bits [start, end) of a line, which may straddle words
+    static int64_t countRange(const std::span<const uint64_t> line, const int64_t start, const int64_t end) {
+        int64_t count = 0;
+        for (int64_t word = start / 64; word * 64 < end; word++) {
+            uint64_t mask = ~uint64_t{ 0 };
+            if (word == start / 64) mask &= ~uint64_t{ 0 } << (start % 64);
+            if (word == (end - 1) / 64) mask &= ~uint64_t{ 0 } >> (63 - (end - 1) % 64);
+            count += std::popcount(line[word] & mask);
+        }
+        return count;
+    }
+
+    static void setRange(const std::span<uint64_t> line, const int64_t start, const int64_t end) {
+        for (int64_t word = start / 64; word * 64 < end; word++) {
+            uint64_t mask = ~uint64_t{ 0 };
+            if (word == start / 64) mask &= ~uint64_t{ 0 } << (start % 64);
+            if (word == (end - 1) / 64) mask &= ~uint64_t{ 0 } >> (63 - (end - 1) % 64);
+            line[word] |= mask;
+        }
+    }
+
+    // 64x64 bit block transpose: bit c of a[r] swaps with bit r of a[c]. Swaps quadrants, then
+    // quadrants of quadrants, and so on down to single bits
+    static void transpose64(std::array<uint64_t, 64>& a) {
+        uint64_t mask = 0x00000000ffffffffull;
+        for (int j = 32; j != 0; j >>= 1, mask ^= (mask << j)) {
+            for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+                const uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+                a[k] ^= t << j;
+                a[k | j] ^= t;
+            }
+        }
+    }
+
+    static void transpose(const BitLines& from, BitLines& to) {
+        std::array<uint64_t, 64> block;
+        for (int64_t fromBlock = 0; fromBlock < to.wordsPerLine; fromBlock++) {
+            for (int64_t word = 0; word < from.wordsPerLine; word++) {
+                for (int64_t i = 0; i < 64; i++) {
+                    const auto l = fromBlock * 64 + i;
+                    block[i] = (l < from.lineCount) ? from.words[l * from.wordsPerLine + word] : 0;
+                }
+                transpose64(block);
+                for (int64_t i = 0; i < 64 && word * 64 + i < to.lineCount; i++) {
+                    to.words[(word * 64 + i) * to.wordsPerLine + fromBlock] = block[i];
+                }
+            }
+        }
+    }
+
+    // piles each segment's rocks up at its start (or end), and optionally hashes where they landed
+    void tilt(BitLines& lines, const std::vector<std::vector<Segment>>& segments, const bool towardStart, uint64_t* hash = nullptr) {
+        for (int64_t l = 0; l < std::ssize(segments); l++) {
+            const auto line = lines.line(l);
+            mCounts.clear();
+            for (const auto& segment : segments[l]) {
+                mCounts.push_back(countRange(line, segment.start, segment.end));
+            }
+            std::ranges::fill(line, 0);
+            for (int64_t s = 0; s < std::ssize(segments[l]); s++) {
+                const auto& segment = segments[l][s];
+                const auto start = towardStart ? segment.start : segment.end - mCounts[s];
+                const auto end = start + mCounts[s];
+                if (start == end) continue;
+                setRange(line, start, end);
+                if (hash) {
+                    *hash ^= mZobristPrefix[l][start] ^ mZobristPrefix[l][end];
                 }
-                return calculateLoad(finalMap);
             }
         }
-        mapHistory.emplace_back(newMap);
     }
+
+    int64_t mWidth;
+    int64_t mHeight;
+    BitLines mRows;  // a line per y
+    BitLines mCols;  // a line per x
+    std::vector<std::vector<Segment>> mRowSegments;
+    std::vector<std::vector<Segment>> mColSegments;
+    // xor of the per-cell Zobrist keys of a row up to x, so a run of rocks hashes in O(1)
+    std::vector<std::vector<uint64_t>> mZobristPrefix;
+    std::vector<int64_t> mCounts;
+    uint64_t mHash = 0;
+};
+
+int64_t doTheThing2(const std::string& input) {
+    SpinPlatform platform(parseMap(input));
+    CycleFinder<uint64_t> cycleFinder;
+    while (!cycleFinder.add(platform.hash(), platform.northLoad())) {
+        platform.spinCycle();
+    }
+    return cycleFinder.valueAt(1000000000);
 }
 
 const std::string sampleInput = 
@@ -245,6 +423,32 @@ TEST(Aoc14Tests, sampleInput_oneCycle_expectedMap) {
     ASSERT_EQ(expectedMap, doCycle(startingMap, 4));
 }
 
+TEST(Aoc14Tests, cycleFinder_periodicValues) {
+    // 0 1 2 | 3 4 5 6 | 3 4 5 6 ...
+    CycleFinder<int64_t> cycleFinder;
+    int64_t step = 0;
+    for (; !cycleFinder.add(step < 3 ? step : 3 + (step - 3) % 4, step < 3 ? step : 3 + (step - 3) % 4); step++) {}
+    ASSERT_EQ(7, step);
+    ASSERT_EQ(3, cycleFinder.cycleStart());
+    ASSERT_EQ(4, cycleFinder.cycleLength());
+    ASSERT_EQ(2, cycleFinder.valueAt(2));
+    ASSERT_EQ(6, cycleFinder.valueAt(1000002));
+}
+
+TEST(Aoc14Tests, cycleFinder_growingValues) {
+    // the state repeats every 3 steps but the value climbs by 10 each time around
+    CycleFinder<int64_t> cycleFinder;
+    const std::vector<int64_t> values = { 0, 4, 7, 10, 14, 17, 20 };
+    for (int64_t step = 0; step < std::ssize(values); step++) {
+        if (cycleFinder.add(step % 3, values[step])) break;
+    }
+    ASSERT_TRUE(cycleFinder.found());
+    ASSERT_EQ(0, cycleFinder.cycleStart());
+    ASSERT_EQ(3, cycleFinder.cycleLength());
+    ASSERT_EQ(24, cycleFinder.valueAt(7));
+    ASSERT_EQ(3000000001 * 10 + 4, cycleFinder.valueAt(9000000004));
+}
+
 TEST(Aoc14Tests, testtest) {
     ASSERT_EQ(1,1);
 }
@@ -352,6 +556,28 @@ O##O......#..#...#.##O#.O.......#O#.O.............O.......#..O...#.OOO..O..O..OO
 #.O..O..#..O#.#....O...#...O#O#O...OO.OO...##....#..OO#...#...O.#.#O#..O..........#O.O..O...OOO.#...
 )";
 
+TEST(Aoc14Tests, spinPlatform_matchesDoCycle) {
+    // plus one that isn't square and doesn't fit in a word either way
+    std::string lopsided;
+    for (int y = 0; y < 70; y++) {
+        for (int x = 0; x < 131; x++) {
+            lopsided += ".O.#O..O"[(x * 7 + y * 13 + x * y) % 8];
+        }
+        lopsided += '\n';
+    }
+    for (const auto& input : { sampleInput, puzzleInput, lopsided }) {
+        auto map = parseMap(input);
+        SpinPlatform platform(map);
+        for (int i = 0; i < 5; i++) {
+            map = doCycle(map, 4);
+            platform.spinCycle();
+            ASSERT_EQ(map, platform.toMap());
+            ASSERT_EQ(calculateLoad(map), platform.northLoad());
+            ASSERT_EQ(SpinPlatform(map).hash(), platform.hash());
+        }
+    }
+}
+
 TEST(Aoc14Tests, puzzle_doTheThing) {
     ASSERT_EQ(0, doTheThing(puzzleInput));
 }
@@ -0,0 +1,19 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-14-test.cpp"
+
+#include "aoc-bench.h"
+
+// a tiled platform takes far longer to settle into its loop than the real one (most of a minute at
+// x10), so only the single tilt gets the synthetic sizes
+void aoc_bench::registerDay() {
+	add("day14/doTheThing/sample", [] { return doTheThing(sampleInput); });
+	add("day14/doTheThing2/sample", [] { return doTheThing2(sampleInput); });
+	add("day14/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+	add("day14/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput); });
+	for (const auto& [scale, suffix] : scales) {
+		const auto tiles = tilesFor(scale);
+		const auto scaled = tileGrid(puzzleInput, tiles, tiles);
+		add(std::string("day14/doTheThing/") + suffix, [scaled] { return doTheThing(scaled); });
+	}
+}
@@ -9,8 +9,14 @@
 // and ergonomic in that they operate on whole containers instead of begin-end blocks
 
 #include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
 #include <numeric>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace pex {
@@ -108,9 +114,131 @@ namespace pex {
 		return result;
 	}
 
+	// pSplit's lazy cousin: iterating it hands out string_views straight into str, so there's no
+	// stringstream, no string per token and no vector to hold them - str just has to outlive it.
+	// otherwise same rules as pSplit, e.g. a trailing delimiter doesn't make an empty last token
+	template <typename Delim>
+	class SplitRange {
+	public:
+		class iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = const std::string_view&;
+
+			iterator() = default;
+			iterator(const std::string_view str, const Delim delim) : mRest(str), mDelim(delim), mDone(false) { ++(*this); }
+
+			reference operator*() const { return mToken; }
+			pointer operator->() const { return &mToken; }
+
+			iterator& operator++() {
+				if (mRest.empty()) {
+					mDone = true;
+					return *this;
+				}
+				const auto pos = mRest.find(mDelim);
+				mToken = mRest.substr(0, pos);
+				mRest = (pos == std::string_view::npos) ? std::string_view() : mRest.substr(pos + delimSize());
+				return *this;
+			}
+
+			iterator operator++(int) {
+				iterator old = *this;
+				++(*this);
+				return old;
+			}
+
+			bool operator==(const iterator& rhs) const {
+				return mDone == rhs.mDone && (mDone || mToken.data() == rhs.mToken.data());
+			}
+
+		private:
+			size_t delimSize() const {
+				if constexpr (std::is_same_v<Delim, char>) {
+					return 1;
+				}
+				else {
+					return mDelim.size();
+				}
+			}
+
+			std::string_view mToken;
+			std::string_view mRest;
+			Delim mDelim{};
+			bool mDone = true;
+		};
+
+		SplitRange(const std::string_view str, const Delim delim) : mStr(str), mDelim(delim) {}
+
+		iterator begin() const { return iterator(mStr, mDelim); }
+		iterator end() const { return iterator(); }
+
+	private:
+		std::string_view mStr;
+		Delim mDelim;
+	};
+
+	SplitRange<char> pSplitView(const std::string_view str, const char delim) {
+		return { str, delim };
+	}
+
+	SplitRange<std::string_view> pSplitView(const std::string_view str, const std::string_view delim) {
+		assert(!delim.empty());
+		return { str, delim };
+	}
+
 	template <typename T> int sgn(T val) {
 		return (T(0) < val) - (val < T(0));
 	}
+
+	// For "now do it a billion times" puzzles. Feed it the state after every step, starting with the
+	// state after 0 steps, along with whatever number you care about at that step (load, height...).
+	// Once a state repeats, valueAt() can answer for any step without simulating there. If the value
+	// keeps growing every time around the loop (like a tower height) that growth is extrapolated too.
+	// Key only needs operator== and a hash, so it can be the whole state or a good enough fingerprint.
+	template <typename Key, typename Value = int64_t, typename Hash = std::hash<Key>>
+	class CycleFinder {
+	public:
+		// returns true once the cycle is found, after that there's no need to keep adding
+		bool add(const Key& key, const Value& value) {
+			if (found()) {
+				return true;
+			}
+			const int64_t step = std::ssize(mValues);
+			mValues.push_back(value);
+			const auto [firstSeen, inserted] = mFirstSeen.try_emplace(key, step);
+			if (!inserted) {
+				mCycleStart = firstSeen->second;
+				mCycleLength = step - mCycleStart;
+				mFirstSeen.clear();
+			}
+			return found();
+		}
+
+		bool found() const { return mCycleLength > 0; }
+		int64_t cycleStart() const { return mCycleStart; }
+		int64_t cycleLength() const { return mCycleLength; }
+
+		Value valueAt(const int64_t step) const {
+			if (step < std::ssize(mValues)) {
+				return mValues[step];
+			}
+			assert(found());
+			const int64_t loops = (step - mCycleStart) / mCycleLength;
+			const int64_t offset = (step - mCycleStart) % mCycleLength;
+			const Value growthPerLoop = mValues[mCycleStart + mCycleLength] - mValues[mCycleStart];
+			return mValues[mCycleStart + offset] + growthPerLoop * loops;
+		}
+
+	private:
+		std::unordered_map<Key, int64_t, Hash> mFirstSeen;
+		std::vector<Value> mValues;
+		int64_t mCycleStart = 0;
+		int64_t mCycleLength = 0;
+	};
 }
 
 struct Vec2 {
@@ -8,7 +8,7 @@
 
 using namespace pex;
 
-int64_t hashStep(const std::string& step) {
+int64_t hashStep(const std::string_view step) {
     int64_t hash = 0;
     for (const auto& c : step) {
         hash += c;
@@ -19,8 +19,7 @@ int64_t hashStep(const std::string& step) {
 }
 
 int64_t doTheThing(const std::string& input) {
-    const auto splitInput = pSplit(input, ',');
-    const int64_t result = pAccumulate(splitInput, 0ll, [](const int64_t sum, const std::string& step) {
+    const int64_t result = pAccumulate(pSplitView(input, ','), 0ll, [](const int64_t sum, const std::string_view step) {
         return sum + hashStep(step);
         });
     return result;
@@ -106,9 +105,8 @@ int64_t totalFocusingPower(Box boxes[256]) {
 }
 
 int64_t doTheThing2(const std::string& input) {
-    const auto splitInput = pSplit(input, ',');
     Box boxes[256];
-    for (const auto& step : splitInput) {
+    for (const auto& step : pSplitView(input, ',')) {
         std::regex pattern("([a-zA-Z]+)([-=])([0-9]*)");
         auto regexResult = std::regex_iterator(step.begin(), step.end(), pattern);
         const std::string label = (*regexResult)[1];
@@ -124,6 +122,21 @@ TEST(Aoc15Tests, testtest) {
     ASSERT_EQ(1,1);
 }
 
+TEST(Aoc15Tests, pSplitView_matchesPSplit) {
+    for (const auto& str : { std::string("a,,b,"), std::string(",x"), std::string(""), sampleInput }) {
+        const auto owned = pSplit(str, ',');
+        std::vector<std::string_view> views;
+        for (const auto& token : pSplitView(str, ',')) {
+            ASSERT_TRUE(token.empty() || (token.data() >= str.data() && token.data() < str.data() + str.size()));
+            views.push_back(token);
+        }
+        ASSERT_EQ(owned.size(), views.size());
+        for (size_t i = 0; i < owned.size(); i++) {
+            ASSERT_EQ(owned[i], views[i]);
+        }
+    }
+}
+
 TEST(Aoc15Tests, sample_doTheThing_1320) {
     ASSERT_EQ(1320, doTheThing(sampleInput));
 }
@@ -0,0 +1,17 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-15-test.cpp"
+
+#include "aoc-bench.h"
+
+void aoc_bench::registerDay() {
+	add("day15/doTheThing/sample", [] { return doTheThing(sampleInput); });
+	add("day15/doTheThing2/sample", [] { return doTheThing2(sampleInput); });
+	add("day15/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+	add("day15/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput); });
+	for (const auto& [scale, suffix] : scales) {
+		const auto scaled = repeatRecords(puzzleInput, ",", scale);
+		add(std::string("day15/doTheThing/") + suffix, [scaled] { return doTheThing(scaled); });
+		add(std::string("day15/doTheThing2/") + suffix, [scaled] { return doTheThing2(scaled); });
+	}
+}
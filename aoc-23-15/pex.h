@@ -9,8 +9,12 @@
 // and ergonomic in that they operate on whole containers instead of begin-end blocks
 
 #include <algorithm>
+#include <cassert>
+#include <iterator>
 #include <numeric>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace pex {
@@ -108,5 +112,81 @@ namespace pex {
 		return result;
 	}
 
+	// pSplit's lazy cousin: iterating it hands out string_views straight into str, so there's no
+	// stringstream, no string per token and no vector to hold them - str just has to outlive it.
+	// otherwise same rules as pSplit, e.g. a trailing delimiter doesn't make an empty last token
+	template <typename Delim>
+	class SplitRange {
+	public:
+		class iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = const std::string_view&;
+
+			iterator() = default;
+			iterator(const std::string_view str, const Delim delim) : mRest(str), mDelim(delim), mDone(false) { ++(*this); }
+
+			reference operator*() const { return mToken; }
+			pointer operator->() const { return &mToken; }
+
+			iterator& operator++() {
+				if (mRest.empty()) {
+					mDone = true;
+					return *this;
+				}
+				const auto pos = mRest.find(mDelim);
+				mToken = mRest.substr(0, pos);
+				mRest = (pos == std::string_view::npos) ? std::string_view() : mRest.substr(pos + delimSize());
+				return *this;
+			}
+
+			iterator operator++(int) {
+				iterator old = *this;
+				++(*this);
+				return old;
+			}
+
+			bool operator==(const iterator& rhs) const {
+				return mDone == rhs.mDone && (mDone || mToken.data() == rhs.mToken.data());
+			}
+
+		private:
+			size_t delimSize() const {
+				if constexpr (std::is_same_v<Delim, char>) {
+					return 1;
+				}
+				else {
+					return mDelim.size();
+				}
+			}
+
+			std::string_view mToken;
+			std::string_view mRest;
+			Delim mDelim{};
+			bool mDone = true;
+		};
+
+		SplitRange(const std::string_view str, const Delim delim) : mStr(str), mDelim(delim) {}
+
+		iterator begin() const { return iterator(mStr, mDelim); }
+		iterator end() const { return iterator(); }
+
+	private:
+		std::string_view mStr;
+		Delim mDelim;
+	};
+
+	SplitRange<char> pSplitView(const std::string_view str, const char delim) {
+		return { str, delim };
+	}
+
+	SplitRange<std::string_view> pSplitView(const std::string_view str, const std::string_view delim) {
+		assert(!delim.empty());
+		return { str, delim };
+	}
+
 }
 #pragma once
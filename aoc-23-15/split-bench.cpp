@@ -0,0 +1,91 @@
+// counts heap allocations (and time) for pSplit vs pSplitView on the two shapes we actually split:
+// one long comma list like today's input, and day 25 style "abc: def ghi jkl" lines split twice.
+// no gtest here on purpose, build it in Release and just run it.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "pex.h"
+
+using namespace pex;
+
+static std::atomic<int64_t> allocations{ 0 };
+
+void* operator new(std::size_t size) {
+	allocations++;
+	if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+std::string makeCommaList(const int count) {
+	std::string result;
+	uint32_t seed = 12345;
+	for (int i = 0; i < count; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		result += std::string(2 + (seed >> 30), static_cast<char>('a' + (seed >> 24) % 26));
+		result += (seed & 1) ? "-," : "=7,";
+	}
+	return result;
+}
+
+std::string makeWiringLines(const int count) {
+	std::string result;
+	for (int i = 0; i < count; i++) {
+		result += "abc: def ghi jkl mno pqr stu\n";
+	}
+	return result;
+}
+
+template <typename Func>
+void measure(const char* name, Func func) {
+	const int64_t before = allocations;
+	const auto start = std::chrono::steady_clock::now();
+	const int64_t checksum = func();
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "  " << name << "  " << (allocations - before) << " allocations  "
+		<< std::chrono::duration<double, std::milli>(elapsed).count() << " ms  (checksum " << checksum << ")" << std::endl;
+}
+
+int main() {
+	const std::string commaList = makeCommaList(1'000'000);
+	const std::string wiring = makeWiringLines(200'000);
+
+	std::cout << "comma list, " << commaList.size() << " bytes" << std::endl;
+	measure("pSplit    ", [&]() {
+		int64_t sum = 0;
+		for (const auto& step : pSplit(commaList, ',')) sum += step.size();
+		return sum;
+	});
+	measure("pSplitView", [&]() {
+		int64_t sum = 0;
+		for (const auto& step : pSplitView(commaList, ',')) sum += step.size();
+		return sum;
+	});
+
+	std::cout << "wiring lines, " << wiring.size() << " bytes" << std::endl;
+	measure("pSplit    ", [&]() {
+		int64_t sum = 0;
+		for (const auto& line : pSplit(wiring, '\n')) {
+			for (const auto& word : pSplit(line, ' ')) sum += word.size();
+		}
+		return sum;
+	});
+	measure("pSplitView", [&]() {
+		int64_t sum = 0;
+		for (const auto& line : pSplitView(wiring, '\n')) {
+			for (const auto& word : pSplitView(line, ' ')) sum += word.size();
+		}
+		return sum;
+	});
+	return 0;
+}
@@ -1,5 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <optional>
+#include <thread>
+
 #include "pex.h"
 
 std::unique_ptr<Map> processBeam(std::unique_ptr<Map> highlight, const Map& map, const Vec2& startXY, const Vec2& dir) {
@@ -71,24 +78,300 @@ int64_t doTheThing(const std::string& input) {
 }
 
 
-int64_t doTheThing2(const std::string& input) {
-    auto map = parseMap(input);
-    int64_t maxEnergy;
-    for (int row = 0; row < map.size(); row++) {
-        auto highlight = std::make_unique<Map>(createEmptyMap(map[0].size(), map.size()));
-        auto result = processBeam(std::move(highlight), map, { 0,row }, { 1,0 });
-        maxEnergy = std::max(maxEnergy, mapAccumulate(*result, [](const auto& acc, const auto& cell) { return acc + ((cell != 0) ? 1 : 0); }));
-        auto highlight2 = std::make_unique<Map>(createEmptyMap(map[0].size(), map.size()));
-        auto result2 = processBeam(std::move(highlight2), map, { ssize(map[row])-1,row}, {-1,0});
-        maxEnergy = std::max(maxEnergy, mapAccumulate(*result2, [](const auto& acc, const auto& cell) { return acc + ((cell != 0) ? 1 : 0); }));
+// beam directions, in the same bit order as processBeam's masks
+enum BeamDir : int { Down, Right, Up, Left };
+constexpr int64_t beamDx[4] = { 0, 1, 0, -1 };
+constexpr int64_t beamDy[4] = { 1, 0, -1, 0 };
+constexpr BeamDir slashTurn[4] = { Left, Up, Right, Down };
+constexpr BeamDir backslashTurn[4] = { Right, Down, Left, Up };
+
+BeamDir beamDir(const Vec2& dir) {
+    return (dir == Vec2{ 0, 1 }) ? Down : (dir == Vec2{ 1, 0 }) ? Right : (dir == Vec2{ 0, -1 }) ? Up : Left;
+}
+
+// processBeam without the allocations, for firing lots of beams into the same contraption. Cells
+// get one bit per direction a beam has crossed them in, like the highlight map, but flat and reused:
+// every newly energized cell goes on a list, so the count is just the list's size and clearing up
+// for the next beam only touches those cells.
+class BeamTracer {
+public:
+    explicit BeamTracer(const Map& map) : mMap(map), mSeen(map.width() * map.height(), 0) {}
+
+    int64_t energize(const Vec2& start, const Vec2& dir) {
+        for (const auto idx : mEnergized) {
+            mSeen[idx] = 0;
+        }
+        mEnergized.clear();
+        mPending.push_back({ start.x, start.y, beamDir(dir) });
+        while (!mPending.empty()) {
+            auto [x, y, d] = mPending.back();
+            mPending.pop_back();
+            while (x >= 0 && y >= 0 && x < mMap.width() && y < mMap.height()) {
+                const auto idx = y * mMap.width() + x;
+                const uint8_t mask = 1 << d;
+                if (mSeen[idx] & mask) {
+                    break;
+                }
+                if (mSeen[idx] == 0) {
+                    mEnergized.push_back(idx);
+                }
+                mSeen[idx] |= mask;
+
+                switch (mMap[y][x]) {
+                case '/': d = slashTurn[d]; break;
+                case '\\': d = backslashTurn[d]; break;
+                case '-':
+                    if (beamDx[d] == 0) {
+                        mPending.push_back({ x + beamDx[Left], y, Left });
+                        d = Right;
+                    }
+                    break;
+                case '|':
+                    if (beamDy[d] == 0) {
+                        mPending.push_back({ x, y + beamDy[Up], Up });
+                        d = Down;
+                    }
+                    break;
+                }
+                x += beamDx[d];
+                y += beamDy[d];
+            }
+        }
+        return std::ssize(mEnergized);
+    }
+
+private:
+    struct Beam {
+        int64_t x;
+        int64_t y;
+        BeamDir d;
+    };
+
+    const Map& mMap;
+    std::vector<uint8_t> mSeen;
+    std::vector<int64_t> mEnergized;
+    std::vector<Beam> mPending;
+};
+
+// every cell on the edge, pointing inwards
+std::vector<std::pair<Vec2, Vec2>> edgeLaunches(const Map& map) {
+    std::vector<std::pair<Vec2, Vec2>> launches;
+    for (int64_t row = 0; row < map.height(); row++) {
+        launches.push_back({ { 0, row }, { 1, 0 } });
+        launches.push_back({ { map.width() - 1, row }, { -1, 0 } });
+    }
+    for (int64_t col = 0; col < map.width(); col++) {
+        launches.push_back({ { col, 0 }, { 0, 1 } });
+        launches.push_back({ { col, map.height() - 1 }, { 0, -1 } });
+    }
+    return launches;
+}
+
+// launches are handed out one at a time off a shared counter, since some beams wander the whole
+// contraption and some fall straight out the other side
+int64_t maxEnergyTraced(const std::string& input, const unsigned requestedThreads = std::max(1u, std::thread::hardware_concurrency())) {
+    const auto threads = std::max(1u, requestedThreads);  // 0 would leave nothing to take the max of
+    const auto map = parseMap(input);
+    const auto launches = edgeLaunches(map);
+    std::atomic<int64_t> nextLaunch = 0;
+    std::vector<int64_t> maxEnergy(threads, 0);
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                BeamTracer tracer(map);
+                for (auto i = nextLaunch++; i < std::ssize(launches); i = nextLaunch++) {
+                    maxEnergy[t] = std::max(maxEnergy[t], tracer.energize(launches[i].first, launches[i].second));
+                }
+            });
+        }
     }
-    for (int col = 0; col < ssize(map[0]); col++) {
-        auto highlight = std::make_unique<Map>(createEmptyMap(map[0].size(), map.size()));
-        auto result = processBeam(std::move(highlight), map, { col,0 }, { 0,1 });
-        maxEnergy = std::max(maxEnergy, mapAccumulate(*result, [](const auto& acc, const auto& cell) { return acc + ((cell != 0) ? 1 : 0); }));
-        auto highlight2 = std::make_unique<Map>(createEmptyMap(map[0].size(), map.size()));
-        auto result2 = processBeam(std::move(highlight2), map, { col,ssize(map) - 1 }, { 0,-1 });
-        maxEnergy = std::max(maxEnergy, mapAccumulate(*result2, [](const auto& acc, const auto& cell) { return acc + ((cell != 0) ? 1 : 0); }));
+    return *std::ranges::max_element(maxEnergy);
+}
+
+// Answers every launch at once instead of tracing each one. A node is a straight run of beam: it starts
+// at a cell heading some direction and goes until it hits a mirror or the flat side of a splitter (or
+// leaves), and its successors are the one or two runs that come out the other side. Beam loops become
+// strongly connected components, which get collapsed (Tarjan), so what's left is a DAG. Going from the
+// sinks up, each component gets a bitset of every cell energized from it, its own runs OR'd with its
+// successors' sets, and then a launch is just the popcount of its component's set.
+// That's a bitset per component, so a huge contraption full of mirrors will want a lot of memory.
+class BeamGraph {
+public:
+    explicit BeamGraph(const Map& map)
+        : mMap(map), mWordsPerSet((map.width() * map.height() + 63) / 64),
+          mNodeAt(map.width() * map.height() * 4, noNode) {
+        for (const auto& [start, dir] : edgeLaunches(map)) {
+            nodeFor(start.x, start.y, beamDir(dir));
+        }
+        // nodeFor appends, so this also gets to every node reachable from the edges
+        for (int64_t node = 0; node < std::ssize(mNodes); node++) {
+            const auto successors = walk(mNodes[node], [](int64_t) {});
+            for (int i = 0; i < 2; i++) {
+                const auto& next = successors[i];
+                mNodes[node].next[i] = next.has_value() ? nodeFor(next->x, next->y, next->d) : noNode;
+            }
+        }
+        condense();
+        fillEnergized();
+    }
+
+    int64_t energized(const Vec2& start, const Vec2& dir) const {
+        const auto node = mNodeAt[cellIdx(start.x, start.y) * 4 + beamDir(dir)];
+        assert(node != noNode);
+        return mComponentEnergy[mNodes[node].component];
+    }
+
+    int64_t nodeCount() const { return std::ssize(mNodes); }
+    int64_t componentCount() const { return std::ssize(mComponentEnergy); }
+
+private:
+    static constexpr int64_t noNode = -1;
+
+    struct Start {
+        int64_t x;
+        int64_t y;
+        BeamDir d;
+    };
+
+    struct Node {
+        Start start;
+        std::array<int64_t, 2> next = { noNode, noNode };
+        int64_t component = noNode;
+    };
+
+    int64_t cellIdx(const int64_t x, const int64_t y) const { return y * mMap.width() + x; }
+
+    bool inBounds(const int64_t x, const int64_t y) const { return x >= 0 && y >= 0 && x < mMap.width() && y < mMap.height(); }
+
+    int64_t nodeFor(const int64_t x, const int64_t y, const BeamDir d) {
+        auto& node = mNodeAt[cellIdx(x, y) * 4 + d];
+        if (node == noNode) {
+            node = std::ssize(mNodes);
+            mNodes.push_back({ { x, y, d } });
+        }
+        return node;
+    }
+
+    // follows a run from its start, calling onCell with each cell it crosses, and returns where
+    // the beam (or beams) go next
+    template <typename OnCell>
+    std::array<std::optional<Start>, 2> walk(const Node& node, OnCell onCell) const {
+        auto [x, y, d] = node.start;
+        const auto next = [&](const BeamDir dir) -> std::optional<Start> {
+            if (!inBounds(x + beamDx[dir], y + beamDy[dir])) return std::nullopt;
+            return Start{ x + beamDx[dir], y + beamDy[dir], dir };
+        };
+        for (;;) {
+            onCell(cellIdx(x, y));
+            switch (mMap[y][x]) {
+            case '/': return { next(slashTurn[d]), std::nullopt };
+            case '\\': return { next(backslashTurn[d]), std::nullopt };
+            case '-':
+                if (beamDx[d] == 0) return { next(Left), next(Right) };
+                break;
+            case '|':
+                if (beamDy[d] == 0) return { next(Up), next(Down) };
+                break;
+            }
+            if (!inBounds(x + beamDx[d], y + beamDy[d])) {
+                return { std::nullopt, std::nullopt };
+            }
+            x += beamDx[d];
+            y += beamDy[d];
+        }
+    }
+
+    // iterative Tarjan, so a long chain of runs can't blow the stack. Components come out numbered
+    // sinks first
+    void condense() {
+        std::vector<int64_t> index(mNodes.size(), noNode);
+        std::vector<int64_t> low(mNodes.size(), 0);
+        std::vector<bool> onStack(mNodes.size(), false);
+        std::vector<int64_t> stack;
+        std::vector<std::pair<int64_t, int>> callStack;
+        int64_t counter = 0;
+        int64_t components = 0;
+        const auto visit = [&](const int64_t node) {
+            index[node] = low[node] = counter++;
+            stack.push_back(node);
+            onStack[node] = true;
+            callStack.push_back({ node, 0 });
+        };
+        for (int64_t root = 0; root < std::ssize(mNodes); root++) {
+            if (index[root] != noNode) continue;
+            visit(root);
+            while (!callStack.empty()) {
+                auto& [node, nextIdx] = callStack.back();
+                if (nextIdx < 2) {
+                    const auto next = mNodes[node].next[nextIdx++];
+                    if (next == noNode) continue;
+                    if (index[next] == noNode) {
+                        visit(next);
+                    }
+                    else if (onStack[next]) {
+                        low[node] = std::min(low[node], index[next]);
+                    }
+                    continue;
+                }
+                const auto finished = node;
+                callStack.pop_back();
+                if (low[finished] == index[finished]) {
+                    for (int64_t member = noNode; member != finished;) {
+                        member = stack.back();
+                        stack.pop_back();
+                        onStack[member] = false;
+                        mNodes[member].component = components;
+                    }
+                    components++;
+                }
+                if (!callStack.empty()) {
+                    const auto parent = callStack.back().first;
+                    low[parent] = std::min(low[parent], low[finished]);
+                }
+            }
+        }
+        mComponentEnergy.assign(components, 0);
+    }
+
+    void fillEnergized() {
+        std::vector<std::vector<int64_t>> members(mComponentEnergy.size());
+        for (int64_t node = 0; node < std::ssize(mNodes); node++) {
+            members[mNodes[node].component].push_back(node);
+        }
+        std::vector<uint64_t> sets(mComponentEnergy.size() * mWordsPerSet, 0);
+        // successors in other components always have lower numbers, so their sets are already done
+        for (int64_t component = 0; component < std::ssize(members); component++) {
+            uint64_t* set = sets.data() + component * mWordsPerSet;
+            for (const auto node : members[component]) {
+                walk(mNodes[node], [set](const int64_t idx) { set[idx / 64] |= uint64_t{ 1 } << (idx % 64); });
+                for (const auto next : mNodes[node].next) {
+                    if (next == noNode || mNodes[next].component == component) continue;
+                    const uint64_t* nextSet = sets.data() + mNodes[next].component * mWordsPerSet;
+                    for (int64_t w = 0; w < mWordsPerSet; w++) {
+                        set[w] |= nextSet[w];
+                    }
+                }
+            }
+            for (int64_t w = 0; w < mWordsPerSet; w++) {
+                mComponentEnergy[component] += std::popcount(set[w]);
+            }
+        }
+    }
+
+    const Map& mMap;
+    int64_t mWordsPerSet;
+    std::vector<int64_t> mNodeAt;  // cell * 4 + direction -> node
+    std::vector<Node> mNodes;
+    std::vector<int64_t> mComponentEnergy;
+};
+
+int64_t doTheThing2(const std::string& input) {
+    const auto map = parseMap(input);
+    const BeamGraph graph(map);
+    int64_t maxEnergy = 0;
+    for (const auto& [start, dir] : edgeLaunches(map)) {
+        maxEnergy = std::max(maxEnergy, graph.energized(start, dir));
     }
     return maxEnergy;
 }
@@ -227,6 +510,51 @@ R"(\....../.-...--.|....\../.......|......|.\......../..................|......|
 ........|./......|\.................\....|\.................-.../........./..............\-.....-....../....-.
 )";
 
+TEST(Aoc16Test, beamTracer_matchesProcessBeam) {
+    const auto map = parseMap(puzzleInput);
+    BeamTracer tracer(map);
+    for (const auto& [start, dir] : edgeLaunches(map)) {
+        const auto highlight = processBeam(std::make_unique<Map>(createEmptyMap(map.width(), map.height())), map, start, dir);
+        ASSERT_EQ(mapAccumulate(*highlight, [](const auto& acc, const auto& cell) { return acc + ((cell != 0) ? 1 : 0); }),
+            tracer.energize(start, dir));
+    }
+}
+
+TEST(Aoc16Test, puzzleInput_maxEnergyTraced_sameForAnyThreadCount) {
+    const auto oneThread = maxEnergyTraced(puzzleInput, 1);
+    ASSERT_EQ(oneThread, maxEnergyTraced(puzzleInput, 0));
+    ASSERT_EQ(oneThread, maxEnergyTraced(puzzleInput, 3));
+    ASSERT_EQ(oneThread, maxEnergyTraced(puzzleInput, 16));
+}
+
+TEST(Aoc16Test, beamGraph_matchesBeamTracer) {
+    for (const auto& input : { sampleInput, puzzleInput }) {
+        const auto map = parseMap(input);
+        const BeamGraph graph(map);
+        BeamTracer tracer(map);
+        for (const auto& [start, dir] : edgeLaunches(map)) {
+            ASSERT_EQ(tracer.energize(start, dir), graph.energized(start, dir));
+        }
+    }
+}
+
+// four splitters feeding each other in a ring, so the beam loops
+TEST(Aoc16Test, beamGraph_loopCollapses) {
+    const std::string loop =
+        "..........\n"
+        ".|....-...\n"
+        "..........\n"
+        ".-....|...\n"
+        "..........\n";
+    const auto map = parseMap(loop);
+    const BeamGraph graph(map);
+    ASSERT_LT(graph.componentCount(), graph.nodeCount());
+    BeamTracer tracer(map);
+    for (const auto& [start, dir] : edgeLaunches(map)) {
+        ASSERT_EQ(tracer.energize(start, dir), graph.energized(start, dir));
+    }
+}
+
 TEST(Aoc16Test, puzzleInput_doTheThing) {
     ASSERT_EQ(0, doTheThing(puzzleInput));
 }
@@ -0,0 +1,19 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-16-test.cpp"
+
+#include "aoc-bench.h"
+
+void aoc_bench::registerDay() {
+	add("day16/doTheThing/sample", [] { return doTheThing(sampleInput); });
+	add("day16/doTheThing2/sample", [] { return doTheThing2(sampleInput); });
+	add("day16/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+	add("day16/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput); });
+	add("day16/maxEnergyTraced/puzzle", [] { return maxEnergyTraced(puzzleInput); });
+	for (const auto& [scale, suffix] : scales) {
+		const auto tiles = tilesFor(scale);
+		const auto scaled = tileGrid(puzzleInput, tiles, tiles);
+		add(std::string("day16/doTheThing/") + suffix, [scaled] { return doTheThing(scaled); });
+		add(std::string("day16/doTheThing2/") + suffix, [scaled] { return doTheThing2(scaled); });
+	}
+}
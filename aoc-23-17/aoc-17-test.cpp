@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <queue>
 
 #include "pex.h"
@@ -83,14 +85,6 @@ struct MemoNode {
     StepCode lastStepCode = -1;
 };
 
-struct MemoNode2 {
-    int minCost = INT_MAX;
-    Vec2 spot = Vec2(-1, -1);
-    int lastCardinalDir = -1;
-    int lastNumSteps = 0;
-    int totalStepsInLine = 0;
-};
-
 using MemoGrids = std::vector<Grid<MemoNode>>;
 
 
@@ -228,146 +222,118 @@ int64_t dpThatFucker(
     return findBestResult(memoGrids);
 }
 
-int moveCost(const HeatMap& heatMap, const Vec2& start, const Vec2& end) {
-    const Vec2 stepDelta = { sgn(end.x - start.x), sgn(end.y - start.y) };
-    assert(stepDelta.x == 0 || stepDelta.y == 0);
-    int cost = 0;
-    for (auto step = start;;) {
-        step += stepDelta;
-        cost += heatMap[step.y][step.x];
-        if (step == end) {
-            break;
+// Dijkstra over (y, x, axis of the last run) instead of over single steps: from a cell you always turn,
+// and then go MinRun to MaxRun cells in a straight line, so "how long have I been going straight" never
+// has to be part of the state. Part 1 is <1, 3>, part 2 is <4, 10>.
+// Edges cost at most 9 * MaxRun, so the queue is a ring of buckets indexed by cost (Dial's algorithm)
+// rather than a heap, and run costs come out of per-row and per-column prefix sums instead of walking
+// the run cell by cell.
+template <int MinRun, int MaxRun>
+class ConstrainedGridDijkstra {
+public:
+    explicit ConstrainedGridDijkstra(const HeatMap& heatMap)
+        : mWidth(gridWidth(heatMap)), mHeight(gridHeight(heatMap)),
+          mRowPrefix(mHeight * (mWidth + 1), 0), mColPrefix(mWidth * (mHeight + 1), 0) {
+        int maxHeat = 0;
+        for (int64_t y = 0; y < mHeight; y++) {
+            for (int64_t x = 0; x < mWidth; x++) {
+                const int heat = heatMap[y][x];
+                maxHeat = std::max(maxHeat, heat);
+                mRowPrefix[y * (mWidth + 1) + x + 1] = mRowPrefix[y * (mWidth + 1) + x] + heat;
+                mColPrefix[x * (mHeight + 1) + y + 1] = mColPrefix[x * (mHeight + 1) + y] + heat;
+            }
         }
+        mBucketCount = maxHeat * MaxRun + 1;
     }
-    return cost;
-}
-
-int dpThatFucker2(
-    const HeatMap& heatMap) {
 
-    std::vector<std::vector<std::vector<std::vector<int>>>> memoGrids(4); // [numSteps-1][dir][y][x]
-    for (auto& i : memoGrids) {
-        i.resize(4);
-        for (auto& j : i) {
-            j.resize(gridHeight(heatMap));
-            for (auto& k : j) {
-                k.resize(gridWidth(heatMap), INT_MAX);
+    // top left to bottom right, the top left cell doesn't count
+    int minimumHeat() const {
+        std::vector<int> best(mWidth * mHeight * 2, INT_MAX);
+        std::vector<std::vector<int32_t>> buckets(mBucketCount);
+        int64_t queued = 0;
+        const auto relax = [&](const int32_t state, const int cost) {
+            if (cost < best[state]) {
+                best[state] = cost;
+                buckets[cost % mBucketCount].push_back(state);
+                queued++;
             }
-        }
-    }
-    
-    std::queue<MemoNode2> stepQueue;
-    memoGrids[0][0][0][0]/*.minCost*/ = 0; // heatMap[0][0];  0,0 is _not_ added to heat
-    stepQueue.push(MemoNode2{ 0, {0,0}, -1, 0, 0 });
-    for (; !stepQueue.empty();) {
-        const auto lastMemo = stepQueue.front();
-        stepQueue.pop();
-        //const auto lastDeltaNorm = Vec2{ sgn(lastDelta.y - lastDelta.y), sgn(lastDelta.x - lastDelta.x) };
-        const auto lastCardinalDir = lastMemo.lastCardinalDir;
-        const auto backwards = (lastCardinalDir == -1) ? (-1) : ((lastCardinalDir + 2) % 4);
-        const auto spot = lastMemo.spot;
-        //const auto lastNumSteps = 
-        //assert(lastDeltaNorm.x == 0 || lastDeltaNorm.y == 0);
-        // take 1, 2 or 3 steps
-        for (int numSteps = 1; numSteps <= 3; numSteps++) {
-            for (int cardinalDir = 0; cardinalDir < 4; cardinalDir++) {
-                const auto delta = dirs[cardinalDir];
-                if (cardinalDir != backwards) {
-                    if (cardinalDir != lastCardinalDir) { // we cover the route of going in the "same direction" with our 1, 2, or 3 steps
-                        const auto nextStep = spot + delta * numSteps;
-                        if (inBounds(heatMap, nextStep)) {
-                            const auto cost = moveCost(heatMap, spot, nextStep) + lastMemo.minCost;
-
-                            if (cost < memoGrids[numSteps - 1][cardinalDir][nextStep.y][nextStep.x]/*.minCost*/) {
-                                // memoGrid holds info about how we got here
-                                memoGrids[numSteps - 1][cardinalDir][nextStep.y][nextStep.x] = cost;
-                                //MemoNode2{ cost, spot, 0, 0 };
-
-                                if ((nextStep.y != gridHeight(heatMap) - 1) || (nextStep.x != gridWidth(heatMap) - 1)) {
-                                    // stepQueue holds info about where we're going
-                                    stepQueue.push(MemoNode2{ cost, nextStep, cardinalDir, numSteps });
-                                }
-                            }
-                        }
+        };
+        relax(stateIdx(0, 0, Horizontal), 0);
+        relax(stateIdx(0, 0, Vertical), 0);
+
+        for (int cost = 0; queued > 0; cost++) {
+            auto& bucket = buckets[cost % mBucketCount];
+            while (!bucket.empty()) {
+                const auto state = bucket.back();
+                bucket.pop_back();
+                queued--;
+                if (best[state] != cost) {
+                    continue;  // found a cheaper way here after this was queued
+                }
+                const int64_t cell = state / 2;
+                const int64_t x = cell % mWidth;
+                const int64_t y = cell / mWidth;
+                if (x == mWidth - 1 && y == mHeight - 1) {
+                    return cost;
+                }
+                if (state % 2 == Horizontal) {
+                    // so the next run is vertical
+                    for (int64_t run = MinRun; run <= MaxRun && y + run < mHeight; run++) {
+                        relax(stateIdx(x, y + run, Vertical), cost + colCost(x, y + 1, y + run + 1));
+                    }
+                    for (int64_t run = MinRun; run <= MaxRun && y - run >= 0; run++) {
+                        relax(stateIdx(x, y - run, Vertical), cost + colCost(x, y - run, y));
+                    }
+                }
+                else {
+                    for (int64_t run = MinRun; run <= MaxRun && x + run < mWidth; run++) {
+                        relax(stateIdx(x + run, y, Horizontal), cost + rowCost(y, x + 1, x + run + 1));
+                    }
+                    for (int64_t run = MinRun; run <= MaxRun && x - run >= 0; run++) {
+                        relax(stateIdx(x - run, y, Horizontal), cost + rowCost(y, x - run, x));
                     }
                 }
             }
         }
+        return INT_MAX;
     }
-    int bestResult = INT_MAX;
-    for (const auto& stepGrid : memoGrids) {
-        for (const auto& dirGrid : stepGrid) {
-            bestResult = std::min( bestResult, dirGrid[gridHeight(dirGrid) - 1][gridWidth(dirGrid) - 1]/*.minCost*/);
-        }
-    }
-    return bestResult;
-}
 
+private:
+    enum Axis : int32_t { Horizontal, Vertical };
 
-int dpThatFuckerPart2(const HeatMap& heatMap) {
-
-    std::vector<std::vector<std::vector<std::vector<int>>>> memoGrids(4); // [numSteps-1][dir][y][x]
-    for (auto& i : memoGrids) {
-        i.resize(4);  // this time, options are to move 4 blocks in a new direction or 1 block in the same direction
-        for (auto& j : i) {
-            j.resize(gridHeight(heatMap));
-            for (auto& k : j) {
-                k.resize(gridWidth(heatMap), INT_MAX);
-            }
-        }
+    int32_t stateIdx(const int64_t x, const int64_t y, const Axis axis) const {
+        return static_cast<int32_t>((y * mWidth + x) * 2 + axis);
     }
 
-    std::queue<MemoNode2> stepQueue;
-    memoGrids[0][0][0][0]/*.minCost*/ = 0; // heatMap[0][0];  0,0 is _not_ added to heat
-    stepQueue.push(MemoNode2{ 0, {0,0}, -1, 0 });
-    for (; !stepQueue.empty();) {
-        const auto lastMemo = stepQueue.front();
-        stepQueue.pop();
-        //const auto lastDeltaNorm = Vec2{ sgn(lastDelta.y - lastDelta.y), sgn(lastDelta.x - lastDelta.x) };
-        const auto lastCardinalDir = lastMemo.lastCardinalDir;
-        const auto backwards = (lastCardinalDir == -1) ? (-1) : ((lastCardinalDir + 2) % 4);
-        const auto spot = lastMemo.spot;
-        //const auto lastNumSteps = 
-        //assert(lastDeltaNorm.x == 0 || lastDeltaNorm.y == 0);
-        // take 1, 2 or 3 steps
-        for (int cardinalDir = 0; cardinalDir < 4; cardinalDir++) {
-            const auto delta = dirs[cardinalDir];
-            if (cardinalDir != backwards) {
-                int numSteps = (cardinalDir == lastCardinalDir) ? 1 : 4;
-                if (cardinalDir != lastCardinalDir || lastMemo.totalStepsInLine<10) { // we cover the route of going in the "same direction" with our 1, 2, or 3 steps
-                    const auto nextStep = spot + delta * numSteps;
-                    if (inBounds(heatMap, nextStep)) {
-                        const auto cost = moveCost(heatMap, spot, nextStep) + lastMemo.minCost;
-
-                        if (cost < memoGrids[numSteps - 1][cardinalDir][nextStep.y][nextStep.x]/*.minCost*/) {
-                            // memoGrid holds info about how we got here
-                            memoGrids[numSteps - 1][cardinalDir][nextStep.y][nextStep.x] = cost;
-                            //MemoNode2{ cost, spot, 0, 0 };
-
-                            if ((nextStep.y != gridHeight(heatMap) - 1) || (nextStep.x != gridWidth(heatMap) - 1)) {
-                                // stepQueue holds info about where we're going
-                                int totalStepsInLine = cardinalDir != lastCardinalDir ? numSteps : lastMemo.totalStepsInLine + 1;
-                                stepQueue.push(MemoNode2{ cost, nextStep, cardinalDir, numSteps, totalStepsInLine });
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    // heat of cells [fromX, toX) in row y
+    int rowCost(const int64_t y, const int64_t fromX, const int64_t toX) const {
+        return mRowPrefix[y * (mWidth + 1) + toX] - mRowPrefix[y * (mWidth + 1) + fromX];
     }
-    int bestResult = INT_MAX;
-    for (const auto& stepGrid : memoGrids) {
-        for (const auto& dirGrid : stepGrid) {
-            bestResult = std::min(bestResult, dirGrid[gridHeight(dirGrid) - 1][gridWidth(dirGrid) - 1]/*.minCost*/);
-        }
+
+    int colCost(const int64_t x, const int64_t fromY, const int64_t toY) const {
+        return mColPrefix[x * (mHeight + 1) + toY] - mColPrefix[x * (mHeight + 1) + fromY];
     }
-    return bestResult;
+
+    int64_t mWidth;
+    int64_t mHeight;
+    std::vector<int> mRowPrefix;
+    std::vector<int> mColPrefix;
+    int mBucketCount = 1;
+};
+
+int dpThatFucker2(
+    const HeatMap& heatMap) {
+    return ConstrainedGridDijkstra<1, 3>(heatMap).minimumHeat();
+}
+
+int dpThatFuckerPart2(const HeatMap& heatMap) {
+    // this time, runs have to be at least 4 blocks and at most 10
+    return ConstrainedGridDijkstra<4, 10>(heatMap).minimumHeat();
 }
 
 
 int doTheThing(const std::string& input) {
-    const auto charGrid = parseGrid<char>(input);
-    const Grid<int8_t> heatMap = gridTransform<int8_t>(charGrid, [](auto cell) { return cell - '0'; });
+    const HeatMap heatMap = parseGrid<int8_t>(input, [](auto cell) { return cell - '0'; });
     auto bests = makeBestGrids(heatMap);
     auto visited = createGrid<bool>(gridWidth(heatMap), gridHeight(heatMap));
     minimumHeat(heatMap, bests, visited, { 0,0 }, { 0,0 }, -1);
@@ -375,20 +341,17 @@ int doTheThing(const std::string& input) {
 }
 
 int64_t doTheThingDPBFS(const std::string& input) {
-    const auto charGrid = parseGrid<char>(input);
-    const Grid<int8_t> heatMap = gridTransform<int8_t>(charGrid, [](auto cell) { return cell - '0'; });
+    const HeatMap heatMap = parseGrid<int8_t>(input, [](auto cell) { return cell - '0'; });
     return dpThatFucker(heatMap);
 }
 
 int64_t doTheThingDPBFS2(const std::string& input) {
-    const auto charGrid = parseGrid<char>(input);
-    const Grid<int8_t> heatMap = gridTransform<int8_t>(charGrid, [](auto cell) { return cell - '0'; });
+    const HeatMap heatMap = parseGrid<int8_t>(input, [](auto cell) { return cell - '0'; });
     return dpThatFucker2(heatMap);
 }
 
 int64_t doTheThingPart2(const std::string& input) {
-    const auto charGrid = parseGrid<char>(input);
-    const Grid<int8_t> heatMap = gridTransform<int8_t>(charGrid, [](auto cell) { return cell - '0'; });
+    const HeatMap heatMap = parseGrid<int8_t>(input, [](auto cell) { return cell - '0'; });
     return dpThatFuckerPart2(heatMap);
 }
 
@@ -450,6 +413,35 @@ TEST(Aoc17Test, vert4Path_willBeFourInARow_true) {
     ASSERT_TRUE(willBeFourInARow({ 0,5 }, { 0,4 }, 10));
 }
 
+TEST(Aoc17Test, gridView_pointsIntoInput) {
+    const std::string input = "241\r\n321\r\n325";
+    const auto view = gridView(input);
+    ASSERT_TRUE(view);
+    ASSERT_EQ(3, gridWidth(*view));
+    ASSERT_EQ(3, gridHeight(*view));
+    ASSERT_EQ(5, view->stride());
+    ASSERT_EQ(input.data() + 10, (*view)[2].data());
+    ASSERT_EQ('5', (*view)[2][2]);
+}
+
+TEST(Aoc17Test, gridView_raggedRows_nullopt) {
+    ASSERT_FALSE(gridView("241\n32\n3251\n"));
+    ASSERT_FALSE(gridView("2413\n3\n1\n3251\n"));
+}
+
+TEST(Aoc17Test, mapGridFile_matchesParseGrid) {
+    const auto path = (std::filesystem::temp_directory_path() / "aoc-17-mapGridFile.txt").string();
+    std::ofstream(path, std::ios::binary) << sampleInput;
+    {
+        const auto mapped = mapGridFile(path);
+        ASSERT_TRUE(mapped);
+        const HeatMap heatMap = gridTransform<int8_t>(mapped->grid, [](auto cell) { return cell - '0'; });
+        ASSERT_EQ(parseGrid<int8_t>(sampleInput, [](auto cell) { return cell - '0'; }), heatMap);
+        ASSERT_EQ(102, dpThatFucker2(heatMap));
+    }
+    std::filesystem::remove(path);
+}
+
 
 TEST(Aoc17Test, simpleGrid_minimumHeat_9) {
     Grid<int8_t> heatMap{
@@ -527,6 +519,21 @@ TEST(Aoc17Test, simpleGrid_dpbfs2_11) {
     ASSERT_EQ(11, dpThatFucker2(heatMap));// , INT_MAX));
 }
 
+// the step-at-a-time BFS doesn't share any code with the run-at-a-time Dijkstra, so they keep each other honest
+TEST(Aoc17Test, randomGrids_dijkstraMatchesDpbfs) {
+    uint32_t seed = 17;
+    for (int i = 0; i < 20; i++) {
+        auto heatMap = createGrid<int8_t>(5 + i % 7, 4 + i % 5);
+        for (int64_t y = 0; y < gridHeight(heatMap); y++) {
+            for (int64_t x = 0; x < gridWidth(heatMap); x++) {
+                seed = seed * 1664525u + 1013904223u;
+                heatMap[y][x] = static_cast<int8_t>(1 + (seed >> 24) % 9);
+            }
+        }
+        ASSERT_EQ(dpThatFucker(heatMap), dpThatFucker2(heatMap));
+    }
+}
+
 const std::string part2sample =
 R"(111111111111
 999999999991
@@ -720,5 +727,5 @@ TEST(Aoc17Test, puzzleInput_doTheThingDPBFS2) {
 
 TEST(Aoc17Test, puzzleInput_doTheThingPart2) {
     // 1318 is too high
-    ASSERT_EQ(0, doTheThingPart2(puzzleInput));
+    ASSERT_EQ(1283, doTheThingPart2(puzzleInput));
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-17-test.cpp"
+
+#include "aoc-bench.h"
+
+void aoc_bench::registerDay() {
+	add("day17/doTheThing/sample", [] { return doTheThing(sampleInput); });
+	add("day17/doTheThingDPBFS/sample", [] { return doTheThingDPBFS(sampleInput); });
+	add("day17/doTheThingDPBFS2/sample", [] { return doTheThingDPBFS2(sampleInput); });
+	add("day17/doTheThingPart2/sample", [] { return doTheThingPart2(sampleInput); });
+	add("day17/doTheThingDPBFS/puzzle", [] { return doTheThingDPBFS(puzzleInput); });
+	add("day17/doTheThingDPBFS2/puzzle", [] { return doTheThingDPBFS2(puzzleInput); });
+	add("day17/doTheThingPart2/puzzle", [] { return doTheThingPart2(puzzleInput); });
+	// doTheThing is the exhaustive search and only gets the sample, dpThatFucker's memo is already
+	// slow on the puzzle, so only the Dijkstra versions get the big grids
+	for (const auto& [scale, suffix] : scales) {
+		const auto tiles = tilesFor(scale);
+		const auto scaled = tileGrid(puzzleInput, tiles, tiles);
+		add(std::string("day17/doTheThingDPBFS2/") + suffix, [scaled] { return doTheThingDPBFS2(scaled); });
+		add(std::string("day17/doTheThingPart2/") + suffix, [scaled] { return doTheThingPart2(scaled); });
+	}
+}
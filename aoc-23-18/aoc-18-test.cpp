@@ -53,100 +53,102 @@ struct DigInstruction {
 
 constexpr int64_t gridRadius = 512;
 
+// a run of dug cells along a row, both ends included
+struct Span {
+	int64_t left;
+	int64_t right;
+};
+
+// The trench squashed down to what a scanline needs: every vertical run as the row it starts on and
+// the row it stops on. The rows with an event on them are the compressed rows, everything between
+// two of them looks the same.
 struct Mesh {
-	std::vector<int64_t> horizontalPoints;
-	std::vector<int64_t> verticalPoints;
-	std::vector<std::vector<int8_t>> grid;
-	std::size_t idxForX(const int64_t x) const {
-		std::size_t result = std::distance(horizontalPoints.begin(), 
-			std::lower_bound(horizontalPoints.begin(), horizontalPoints.end(), x));
-		assert(horizontalPoints[result] == x);  // the way I've designed this, should be true
-		return result;
-	}
-	std::size_t idxForY(const int64_t y) const {
-		std::size_t result = std::distance(verticalPoints.begin(),
-			std::lower_bound(verticalPoints.begin(), verticalPoints.end(), y));
-		assert(verticalPoints[result] == y);
-		return result;
-	}
-	int64_t cellSize(const std::size_t x, const std::size_t y) const {
-		int64_t left = horizontalPoints[x];
-		int64_t right = horizontalPoints[x + 1];
-		int64_t top = verticalPoints[y];
-		int64_t bottom = verticalPoints[y + 1];
-		return (right - left) * (bottom - top);
-	}
+	struct Event {
+		int64_t y;
+		int64_t x;
+		bool starts;
+	};
+	std::vector<Event> events;  // sorted by y
 };
 
-Mesh createMesh(std::vector<DigInstruction> steps) {
-	std::set<int64_t> horizontalPointSet;
-	std::set<int64_t> verticalPointSet;
+Mesh createMesh(const std::vector<DigInstruction>& steps) {
 	Mesh mesh;
 	int64_t x = 0;
 	int64_t y = 0;
 	for (const auto& step : steps) {
-		horizontalPointSet.insert(x);
-		horizontalPointSet.insert(x + 1);
-		verticalPointSet.insert(y);
-		verticalPointSet.insert(y + 1);
 		switch (step.dir) {
-		case 'U': y -= step.meters; break;
-		case 'D': y += step.meters; break;
+		case 'U':
+			mesh.events.push_back({ y - step.meters, x, true });
+			mesh.events.push_back({ y, x, false });
+			y -= step.meters;
+			break;
+		case 'D':
+			mesh.events.push_back({ y, x, true });
+			mesh.events.push_back({ y + step.meters, x, false });
+			y += step.meters;
+			break;
 		case 'L': x -= step.meters; break;
 		case 'R': x += step.meters; break;
 		}
 	}
-	for (const auto& point : horizontalPointSet) {
-		std::cout << point << " ";
-	}
-	std::cout << std::endl;
-	for (const auto& point : verticalPointSet) {
-		std::cout << point << " ";
-	}
-	std::cout << std::endl;
-	mesh.horizontalPoints = std::vector(horizontalPointSet.begin(), horizontalPointSet.end());
-	mesh.verticalPoints = std::vector(verticalPointSet.begin(), verticalPointSet.end());
-	mesh.grid.resize(mesh.verticalPoints.size());
-	for (auto& row : mesh.grid) {
-		row.resize(mesh.horizontalPoints.size());
-	}
+	std::sort(mesh.events.begin(), mesh.events.end(), [](const auto& a, const auto& b) { return a.y < b.y; });
 	return mesh;
 }
 
-void digMeshBorder(Mesh& mesh, std::vector<DigInstruction> steps) {
-	int64_t x = 0;
-	int64_t y = 0;
-	for (const auto& step : steps) {
-		std::size_t xIdx = mesh.idxForX(x);
-		std::size_t yIdx = mesh.idxForY(y);
-		switch (step.dir) {
-		case 'U':
-			y -= step.meters;
-			for (;mesh.verticalPoints[yIdx] > y;yIdx--) {
-				mesh.grid[yIdx][xIdx] = 1;
-			}
-			break;
-		case 'D':
-			y += step.meters;
-			for (; mesh.verticalPoints[yIdx] < y; yIdx++) {
-				mesh.grid[yIdx][xIdx] = 1;
-			}
-			break;
-		case 'L':
-			x -= step.meters;
-			for (; mesh.horizontalPoints[xIdx] > x; xIdx--) {
-				mesh.grid[yIdx][xIdx] = 1;
+// the union of two sorted lists of spans, touching or overlapping ones merged
+void mergeSpans(const std::vector<Span>& a, const std::vector<Span>& b, std::vector<Span>& result) {
+	result.clear();
+	auto ai = a.begin();
+	auto bi = b.begin();
+	while (ai != a.end() || bi != b.end()) {
+		const Span next = (bi == b.end() || (ai != a.end() && ai->left < bi->left)) ? *ai++ : *bi++;
+		if (!result.empty() && next.left <= result.back().right + 1) {
+			result.back().right = std::max(result.back().right, next.right);
+		}
+		else {
+			result.push_back(next);
+		}
+	}
+}
+
+// Scanline fill of the mesh, top to bottom. The active edges are the xs of the vertical runs crossing
+// the band below the current row, kept sorted, and pairing them off gives that band's spans. A row
+// with corners on it is the union of the band above and the band below, which picks up the
+// horizontal runs of trench. emit(top, height, spans) gets called once per compressed row; the spans
+// go for every row from top to top + height - 1. Nothing here is the size of the grid.
+template <typename Emit>
+void scanMesh(const Mesh& mesh, Emit emit) {
+	std::vector<int64_t> active;
+	std::vector<Span> above;
+	std::vector<Span> below;
+	std::vector<Span> row;
+	for (std::size_t e = 0; e < mesh.events.size();) {
+		const int64_t y = mesh.events[e].y;
+		for (; e < mesh.events.size() && mesh.events[e].y == y; e++) {
+			const auto& event = mesh.events[e];
+			const auto at = std::lower_bound(active.begin(), active.end(), event.x);
+			if (event.starts) {
+				active.insert(at, event.x);
 			}
-			break;
-		case 'R':
-			x += step.meters;
-			for (; mesh.horizontalPoints[xIdx] < x; xIdx++) {
-				mesh.grid[yIdx][xIdx] = 1;
+			else {
+				assert(at != active.end() && *at == event.x);
+				active.erase(at);
 			}
-			break;
 		}
+		assert(active.size() % 2 == 0);
+		below.clear();
+		for (std::size_t i = 0; i < active.size(); i += 2) {
+			below.push_back({ active[i], active[i + 1] });
+		}
+		mergeSpans(above, below, row);
+		emit(y, int64_t(1), row);
+		if (e < mesh.events.size() && mesh.events[e].y > y + 1) {
+			emit(y + 1, mesh.events[e].y - y - 1, below);
+		}
+		std::swap(above, below);
 	}
 }
+
 //struct BP {
 //	enum class Dir {
 //		Horiz,
@@ -246,13 +248,11 @@ int64_t countHoles(const std::vector<std::vector<int8_t>> ground) {
 
 int64_t countMeshHoles(const Mesh& mesh) {
 	int64_t sum = 0;
-	for (std::size_t row = 0; row < mesh.verticalPoints.size(); row++) {
-		for (std::size_t col = 0; col < mesh.horizontalPoints.size(); col++) {
-			if (mesh.grid[row][col]) {
-				sum += mesh.cellSize(col, row);
-			}
+	scanMesh(mesh, [&sum](const int64_t, const int64_t height, const std::vector<Span>& spans) {
+		for (const Span& span : spans) {
+			sum += height * (span.right - span.left + 1);
 		}
-	}
+	});
 	return sum;
 }
 
@@ -264,49 +264,79 @@ std::vector<std::vector<int8_t>> fillBorder(const std::vector<std::vector<int8_t
 	return groundCopy;
 }
 
+// Walks the trench one instruction at a time and keeps three numbers: where it is, the signed area so
+// far (shoelace - with only straight runs it comes down to x * dy summed over the vertical ones) and
+// the trench length. Once it's back at
+// the start, Pick's theorem gives the cells strictly inside the loop (area - trench / 2 + 1), and the
+// trench cells themselves go on top of that.
+class Lagoon {
+public:
+	void dig(const DigInstruction& step) {
+		switch (step.dir) {
+		case 'U': mY -= step.meters; mArea -= mX * step.meters; break;
+		case 'D': mY += step.meters; mArea += mX * step.meters; break;
+		case 'L': mX -= step.meters; break;
+		case 'R': mX += step.meters; break;
+		default: assert(false);
+		}
+		mTrench += step.meters;
+	}
+
+	bool closed() const { return mX == 0 && mY == 0; }
+
+	int64_t area() const {
+		assert(closed());
+		return std::abs(mArea) + mTrench / 2 + 1;
+	}
+
+private:
+	int64_t mX = 0;
+	int64_t mY = 0;
+	int64_t mArea = 0;
+	int64_t mTrench = 0;
+};
+
+int64_t lagoonArea(const std::vector<DigInstruction>& input) {
+	Lagoon lagoon;
+	for (const auto& step : input) {
+		lagoon.dig(step);
+	}
+	return lagoon.area();
+}
+
+// the scanline over the compressed rows, kept to check lagoonArea against
+int64_t meshArea(const std::vector<DigInstruction>& input) {
+	return countMeshHoles(createMesh(input));
+}
+
 int64_t doTheThing(const std::vector<DigInstruction>& input) {
-	Mesh mesh = createMesh(input);
-	digMeshBorder(mesh, input);
-	std::size_t meshX = mesh.idxForX(0);
-	std::size_t meshY = mesh.idxForY(0);
-	floodFill(mesh.grid, int64_t(meshX+1), int64_t(meshY+1));
-	int64_t resultMethod1 = countMeshHoles(mesh);
+	return lagoonArea(input);
+}
 
-	const auto ground = digBorder(input);
-	const auto filledGround = fillBorder(ground, gridRadius+1, gridRadius+1);
-	int64_t resultMethod2 = countHoles(filledGround);
-	assert(resultMethod1 == resultMethod2);
-	return resultMethod1;
+// part 2's reading of an instruction, everything's in the colour
+DigInstruction fromColour(const DigInstruction& inst) {
+	const auto dir = inst.rgb & 0xf;
+	const auto result = DigInstruction{ 
+		(dir == 0) ? 'R' :
+		(dir == 1) ? 'D' :
+		(dir == 2) ? 'L' :
+		(dir == 3) ? 'U' : 'X',
+		static_cast<int64_t>(inst.rgb >> 4),
+		0 };
+	assert(result.dir != 'X');
+	return result;
 }
 
 std::vector<DigInstruction> transformInstructions(const std::vector<DigInstruction>& input) {
-	std::vector<DigInstruction> newInstructions = pTransform<std::vector<DigInstruction>>(input, [](const auto& inst) {
-		const auto dir = inst.rgb & 0xf;
-		const auto result = DigInstruction{ 
-			(dir == 0) ? 'R' :
-			(dir == 1) ? 'D' :
-			(dir == 2) ? 'L' :
-			(dir == 3) ? 'U' : 'X',
-			static_cast<int64_t>(inst.rgb >> 4),
-			0 };
-		assert(result.dir != 'X');
-		return result;
-		});
-	return newInstructions;
+	return pTransform<std::vector<DigInstruction>>(input, fromColour);
 }
 
 int64_t doTheThing2(const std::vector<DigInstruction>& input) {
-	auto newInstructions = transformInstructions(input);
-	Mesh mesh = createMesh(newInstructions);
-	digMeshBorder(mesh, newInstructions);
-	outGrid(mesh.grid);
-	std::size_t meshX = mesh.idxForX(0);
-	std::size_t meshY = mesh.idxForY(0);
-	floodFill(mesh.grid, int64_t(meshX + 1), int64_t(meshY + 1));
-
-	outGrid(mesh.grid);
-	int64_t resultMethod1 = countMeshHoles(mesh);
-	return resultMethod1;
+	Lagoon lagoon;
+	for (const auto& step : input) {
+		lagoon.dig(fromColour(step));
+	}
+	return lagoon.area();
 }
 
 std::vector<DigInstruction> sampleInput = {
@@ -1126,5 +1156,56 @@ TEST(Aoc18Test, puzzleInput_doTheThing1_0) {
 
 
 TEST(Aoc18Test, puzzleInput_doTheThing2_0) {
-	ASSERT_EQ(952408144115, doTheThing2(puzzleInput));
-}
\ No newline at end of file
+	ASSERT_EQ(122109860712709, doTheThing2(puzzleInput));
+}
+
+TEST(Aoc18Test, lagoonArea_matchesMesh) {
+	for (const auto& input : { sampleInput, puzzleInput, transformInstructions(sampleInput), transformInstructions(puzzleInput) }) {
+		ASSERT_EQ(meshArea(input), lagoonArea(input));
+	}
+	// the old 1024x1024 grid agrees too, for the inputs that fit in it
+	ASSERT_EQ(countHoles(fillBorder(digBorder(puzzleInput), gridRadius + 1, gridRadius + 1)), lagoonArea(puzzleInput));
+}
+
+TEST(Aoc18Test, lagoonArea_eitherWayRound) {
+	ASSERT_EQ(1, lagoonArea({}));
+	ASSERT_EQ(36, lagoonArea({ { 'R', 5, 0 }, { 'D', 5, 0 }, { 'L', 5, 0 }, { 'U', 5, 0 } }));
+	ASSERT_EQ(36, lagoonArea({ { 'D', 5, 0 }, { 'R', 5, 0 }, { 'U', 5, 0 }, { 'L', 5, 0 } }));
+	// a notch one cell wide and two deep out of the top edge
+	ASSERT_EQ(9 * 5 - 2, lagoonArea({ { 'R', 2, 0 }, { 'D', 2, 0 }, { 'R', 2, 0 }, { 'U', 2, 0 }, { 'R', 4, 0 },
+		{ 'D', 4, 0 }, { 'L', 8, 0 }, { 'U', 4, 0 } }));
+}
+
+// the spans painted onto a digBorder sized grid, for comparing cell by cell
+std::vector<std::vector<int8_t>> meshGround(const Mesh& mesh) {
+	std::vector<std::vector<int8_t>> ground(gridRadius * 2, std::vector<int8_t>(gridRadius * 2));
+	scanMesh(mesh, [&ground](const int64_t top, const int64_t height, const std::vector<Span>& spans) {
+		for (int64_t y = top; y < top + height; y++) {
+			for (const Span& span : spans) {
+				std::fill(ground[y + gridRadius].begin() + span.left + gridRadius, ground[y + gridRadius].begin() + span.right + gridRadius + 1, int8_t(1));
+			}
+		}
+	});
+	return ground;
+}
+
+TEST(Aoc18Test, scanMesh_matchesFloodFill) {
+	for (const auto& input : { sampleInput, puzzleInput }) {
+		ASSERT_EQ(fillBorder(digBorder(input), gridRadius + 1, gridRadius + 1), meshGround(createMesh(input)));
+	}
+}
+
+TEST(Aoc18Test, scanMesh_compressedRows) {
+	// the notched rectangle from lagoonArea_eitherWayRound: the top edge, the band beside the notch,
+	// the row the notch bottoms out on, the band below that and the bottom edge, spans split by the
+	// notch until it closes
+	const auto mesh = createMesh({ { 'R', 2, 0 }, { 'D', 2, 0 }, { 'R', 2, 0 }, { 'U', 2, 0 }, { 'R', 4, 0 },
+		{ 'D', 4, 0 }, { 'L', 8, 0 }, { 'U', 4, 0 } });
+	std::vector<std::tuple<int64_t, int64_t, int64_t>> rows;
+	scanMesh(mesh, [&rows](const int64_t top, const int64_t height, const std::vector<Span>& spans) {
+		rows.push_back({ top, height, std::ssize(spans) });
+	});
+	const std::vector<std::tuple<int64_t, int64_t, int64_t>> expected = { { 0, 1, 2 }, { 1, 1, 2 }, { 2, 1, 1 }, { 3, 1, 1 }, { 4, 1, 1 } };
+	ASSERT_EQ(expected, rows);
+	ASSERT_EQ(43, countMeshHoles(mesh));
+}
@@ -0,0 +1,47 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-18-test.cpp"
+
+#include "aoc-bench.h"
+
+// a closed staircase, count steps down and to the right then straight back, written the way
+// part 2 reads it (distance and direction in the colour, at most 5 hex digits of distance, same as
+// the real thing). Part 1 reads the meters field instead, so it only gets the real inputs.
+std::vector<DigInstruction> staircase(const int64_t count) {
+	static constexpr int64_t maxMeters = 0xfffff;
+	aoc_bench::Lcg lcg;
+	std::vector<DigInstruction> result;
+	const auto dig = [&result](const char dir, const uint32_t code, int64_t meters) {
+		for (; meters > 0; meters -= maxMeters) {
+			result.push_back({ dir, 1, static_cast<uint32_t>(std::min(meters, maxMeters) << 4) | code });
+		}
+	};
+	int64_t right = 0;
+	int64_t down = 0;
+	for (int64_t i = 0; i < count; i++) {
+		const auto r = lcg.range(1, 1 << 16);
+		const auto d = lcg.range(1, 1 << 16);
+		dig('R', 0, r);
+		dig('D', 1, d);
+		right += r;
+		down += d;
+	}
+	dig('L', 2, right);
+	dig('U', 3, down);
+	return result;
+}
+
+void aoc_bench::registerDay() {
+	add("day18/doTheThing/sample", [] { return doTheThing(sampleInput); });
+	add("day18/doTheThing2/sample", [] { return doTheThing2(sampleInput); });
+	add("day18/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+	add("day18/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput); });
+	const auto puzzle2 = transformInstructions(puzzleInput);
+	add("day18/meshArea/puzzle2", [puzzle2] { return meshArea(puzzle2); });
+	for (const auto& [scale, suffix] : scales) {
+		const auto scaled = staircase(std::ssize(puzzleInput) * scale / 2);
+		add(std::string("day18/doTheThing2/") + suffix, [scaled] { return doTheThing2(scaled); });
+		const auto transformed = transformInstructions(scaled);
+		add(std::string("day18/meshArea/") + suffix, [transformed] { return meshArea(transformed); });
+	}
+}
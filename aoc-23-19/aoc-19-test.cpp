@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <array>
 #include <regex>
 #include <optional>
 
@@ -37,29 +38,31 @@ using Parts = std::vector<Part>;
 std::pair<Workflows, Parts> parseInput(const std::string& input) {
     Workflows workflows;
     Parts parts;
-    const auto lines = pSplit(input, '\n');
+    // string_view flavored smatch, since the lines are views into input
+    using ViewMatch = std::match_results<std::string_view::const_iterator>;
+    const auto lines = pSplitView(input, '\n');
+    // built once rather than once a line - building a std::regex costs far more than matching one
+    static const std::regex workflowRegExp("([a-z]+)\\{(.*)\\}");  // {} has meaning in C++ regex, needs \ to indicate literal, and c++ needs \ to indicate the \ is literal  :P
+    static const std::regex ruleRegExp("([a-z])([<>])([0-9]+):([a-zA-Z]+)");
+    static const std::regex partRegExp("\\{([a-z])=([0-9]+),([a-z])=([0-9]+),([a-z])=([0-9]+),([a-z])=([0-9]+)\\}");
     auto line_it = lines.begin();
     for (; !line_it->empty(); ++line_it ) {
-        std::regex regExpTest("Wah");
-        std::regex regExp("([a-z]+)\\{(.*)\\}");  // {} has meaning in C++ regex, needs \ to indicate literal, and c++ needs \ to indicate the \ is literal  :P
-        std::smatch resultMatch;
-        const bool parsed = regex_match(*line_it, resultMatch, regExp);
+        ViewMatch resultMatch;
+        const bool parsed = regex_match(line_it->begin(), line_it->end(), resultMatch, workflowRegExp);
         assert(parsed);
         const auto workflowName = resultMatch[1];
-        const auto workflowStr = resultMatch[2];
-        const auto ruleStrs = pSplit(workflowStr, ',');
+        const std::string_view workflowStr(resultMatch[2].first, resultMatch[2].second);
         Workflow newWorkflow;
-        for (const auto& ruleStr : ruleStrs) {
+        for (const auto& ruleStr : pSplitView(workflowStr, ',')) {
             if (ruleStr.empty()) {
                 break;
             }
             else if (ruleStr.find(':')==std::string::npos) {
-                newWorkflow.emplace_back(Rule{ std::nullopt,ruleStr });
+                newWorkflow.emplace_back(Rule{ std::nullopt,std::string(ruleStr) });
             }
             else {
-                std::regex regExp("([a-z])([<>])([0-9]+):([a-zA-Z]+)");
-                std::smatch resultMatch;
-                const bool parsed = regex_match(ruleStr, resultMatch, regExp);
+                ViewMatch resultMatch;
+                const bool parsed = regex_match(ruleStr.begin(), ruleStr.end(), resultMatch, ruleRegExp);
                 assert(parsed);
                 Condition condition{ .category = resultMatch[1].str()[0],
                     .op = (resultMatch[2] == ">") ? Condition::Op::GT : Condition::Op::LT,
@@ -73,9 +76,8 @@ std::pair<Workflows, Parts> parseInput(const std::string& input) {
     }
     ++line_it; // onto the parts
     for (; line_it != lines.end(); ++line_it) {
-        std::regex regExp("\\{([a-z])=([0-9]+),([a-z])=([0-9]+),([a-z])=([0-9]+),([a-z])=([0-9]+)\\}");
-        std::smatch resultMatch;
-        const bool parsed = regex_match(*line_it, resultMatch, regExp);
+        ViewMatch resultMatch;
+        const bool parsed = regex_match(line_it->begin(), line_it->end(), resultMatch, partRegExp);
         assert(parsed);
         Part newPart;
         for (auto submatch = resultMatch.begin()+1; submatch != resultMatch.end(); ++submatch) {  //+1 because first submatch is always whole thing
@@ -190,7 +192,8 @@ int64_t partValue(const Part& part) {
     return pReduce(pTransform<std::vector<int64_t>>(part.stats, [](const auto& pair) { return pair.second; }));
 }
 
-int64_t doTheThing(const std::string& input) {
+// the shuntPart original, kept to check doTheThing against
+int64_t shuntedRatings(const std::string& input) {
     const auto [workflows, parts] = parseInput(input);
     const auto values = pTransform<std::vector<int64_t>>(parts, [&workflows](const auto& part) { 
         return shuntPart(workflows, part, "in") ? partValue(part) : 0ll;
@@ -198,7 +201,126 @@ int64_t doTheThing(const std::string& input) {
     return pReduce(values);
 }
 
-int64_t doTheThing2(const std::string& input) {
+// Workflows boiled down to flat arrays: every workflow name becomes an index, every rule's category an
+// index into "xmas", and a workflow's rules are a slice of one shared vector. Built once, after that
+// there's no string or map anywhere.
+struct CompiledRule {
+    int8_t category;  // 0-3 for x, m, a, s, -1 for the catch-all at the end
+    bool greater;
+    int16_t rating;
+    int32_t target;  // a workflow index, or accept/reject
+};
+
+struct CompiledWorkflows {
+    static constexpr int32_t accept = -1;
+    static constexpr int32_t reject = -2;
+
+    int32_t start = reject;
+    std::vector<int32_t> ruleStart;  // workflow w's rules are rules[ruleStart[w]] up to rules[ruleStart[w + 1]]
+    std::vector<CompiledRule> rules;
+};
+
+int8_t categoryIndex(const char category) {
+    const auto index = std::string_view("xmas").find(category);
+    assert(index != std::string_view::npos);
+    return static_cast<int8_t>(index);
+}
+
+CompiledWorkflows compileWorkflows(const Workflows& workflows, const std::string& start = "in") {
+    // map iteration order is the index order, so an index is just how far into the map the name is
+    std::map<std::string_view, int32_t> ids;
+    for (const auto& [name, workflow] : workflows) {
+        ids.emplace(name, static_cast<int32_t>(ids.size()));
+    }
+    const auto target = [&ids](const std::string& name) {
+        return (name == "A") ? CompiledWorkflows::accept : (name == "R") ? CompiledWorkflows::reject : ids.at(name);
+    };
+
+    CompiledWorkflows compiled;
+    compiled.start = target(start);
+    compiled.ruleStart.reserve(workflows.size() + 1);
+    for (const auto& [name, workflow] : workflows) {
+        compiled.ruleStart.push_back(static_cast<int32_t>(compiled.rules.size()));
+        for (const Rule& rule : workflow) {
+            if (const auto& condition = rule.condition) {
+                assert(condition->rating >= 0 && condition->rating <= 4001);
+                compiled.rules.push_back({ categoryIndex(condition->category), condition->op == Condition::Op::GT,
+                    static_cast<int16_t>(condition->rating), target(rule.destination) });
+            }
+            else {
+                compiled.rules.push_back({ -1, false, 0, target(rule.destination) });
+            }
+        }
+        assert(!workflow.empty() && !workflow.back().condition);  // last step is supposed to be a catch-all
+    }
+    compiled.ruleStart.push_back(static_cast<int32_t>(compiled.rules.size()));
+    return compiled;
+}
+
+// every part with min <= rating <= max in each category
+struct PartBox {
+    std::array<int16_t, 4> min;
+    std::array<int16_t, 4> max;
+
+    int64_t volume() const {
+        int64_t result = 1;
+        for (int i = 0; i < 4; i++) {
+            result *= std::max(0, max[i] - min[i] + 1);
+        }
+        return result;
+    }
+};
+
+// divideParts without the recursion: boxes waiting to go through a workflow sit on a stack, each rule
+// cuts off the piece of the box it matches and sends it on, and anything landing on A adds its volume
+// straight to the total
+int64_t acceptedCombinations(const CompiledWorkflows& compiled, const PartBox& space = { { 1, 1, 1, 1 }, { 4000, 4000, 4000, 4000 } }) {
+    int64_t total = 0;
+    std::vector<std::pair<PartBox, int32_t>> stack{ { space, compiled.start } };
+    while (!stack.empty()) {
+        auto [box, workflow] = stack.back();
+        stack.pop_back();
+        if (workflow == CompiledWorkflows::accept) {
+            total += box.volume();
+            continue;
+        }
+        if (workflow == CompiledWorkflows::reject) {
+            continue;
+        }
+        for (int32_t r = compiled.ruleStart[workflow]; r < compiled.ruleStart[workflow + 1]; r++) {
+            const CompiledRule& rule = compiled.rules[r];
+            PartBox matched = box;
+            if (rule.category >= 0) {
+                if (rule.greater) {
+                    matched.min[rule.category] = std::max<int16_t>(box.min[rule.category], rule.rating + 1);
+                    box.max[rule.category] = std::min(box.max[rule.category], rule.rating);
+                }
+                else {
+                    matched.max[rule.category] = std::min<int16_t>(box.max[rule.category], rule.rating - 1);
+                    box.min[rule.category] = std::max(box.min[rule.category], rule.rating);
+                }
+            }
+            else {
+                box.max[0] = 0;  // the catch-all takes whatever's left
+            }
+            if (matched.min[std::max<int8_t>(rule.category, 0)] <= matched.max[std::max<int8_t>(rule.category, 0)]) {
+                if (rule.target == CompiledWorkflows::accept) {
+                    total += matched.volume();
+                }
+                else if (rule.target != CompiledWorkflows::reject) {
+                    stack.push_back({ matched, rule.target });
+                }
+            }
+            if (box.min[std::max<int8_t>(rule.category, 0)] > box.max[std::max<int8_t>(rule.category, 0)]) {
+                break;
+            }
+        }
+    }
+    return total;
+}
+
+// the recursive original, kept to check acceptedCombinations against
+int64_t spanCombinations(const std::string& input) {
     const auto [workflows, parts] = parseInput(input);
     const PartSpan partSpace = {
         Part{.stats = {{'x',1},{'m',1},{'a',1},{'s',1}}},
@@ -213,6 +335,138 @@ int64_t doTheThing2(const std::string& input) {
         });
     return pReduce(values);
 }
+
+int64_t doTheThing2(const std::string& input) {
+    return acceptedCombinations(compileWorkflows(parseInput(input).first));
+}
+
+// Part 1's side of the compiled workflows: every conditional rule becomes one node that says where a
+// part goes if the comparison holds and where it goes if it doesn't, so the catch-alls disappear into
+// the failed branch of the rule before them. A and R are nodes 0 and 1 and point at themselves, which
+// means stepping a part that's already sorted is harmless - no need to branch on whether it's done.
+struct DecisionNode {
+    int16_t sign;  // 1 for >, -1 for <, so either way the test is sign * rating > bound
+    int16_t bound;
+    int8_t category;
+    std::array<int32_t, 2> next;  // [failed, passed]
+};
+
+struct DecisionProgram {
+    static constexpr int32_t accept = 0;
+    static constexpr int32_t reject = 1;
+
+    int32_t start = reject;
+    std::vector<DecisionNode> nodes;
+};
+
+DecisionProgram compileDecisions(const CompiledWorkflows& compiled) {
+    DecisionProgram program;
+    program.nodes.push_back({ 1, 0, 0, { DecisionProgram::accept, DecisionProgram::accept } });
+    program.nodes.push_back({ 1, 0, 0, { DecisionProgram::reject, DecisionProgram::reject } });
+    std::vector<int32_t> nodeOf(compiled.rules.size(), -1);
+    for (size_t r = 0; r < compiled.rules.size(); r++) {
+        if (compiled.rules[r].category >= 0) {
+            nodeOf[r] = static_cast<int32_t>(program.nodes.size());
+            program.nodes.push_back({});
+        }
+    }
+    // where a part sent to rule r ends up: its node, or wherever the catch-all sends it, following
+    // workflows that are nothing but a catch-all until there's a real node or A or R
+    const auto resolve = [&](int32_t r) {
+        for (;;) {
+            if (nodeOf[r] >= 0) {
+                return nodeOf[r];
+            }
+            const int32_t target = compiled.rules[r].target;
+            if (target == CompiledWorkflows::accept) {
+                return DecisionProgram::accept;
+            }
+            if (target == CompiledWorkflows::reject) {
+                return DecisionProgram::reject;
+            }
+            r = compiled.ruleStart[target];
+        }
+    };
+    const auto resolveWorkflow = [&](const int32_t workflow) {
+        return (workflow == CompiledWorkflows::accept) ? DecisionProgram::accept
+            : (workflow == CompiledWorkflows::reject) ? DecisionProgram::reject
+            : resolve(compiled.ruleStart[workflow]);
+    };
+    for (size_t r = 0; r < compiled.rules.size(); r++) {
+        const CompiledRule& rule = compiled.rules[r];
+        if (rule.category < 0) {
+            continue;
+        }
+        // a conditional rule is never last in its workflow, so r + 1 is the rest of the same workflow
+        program.nodes[nodeOf[r]] = { static_cast<int16_t>(rule.greater ? 1 : -1), static_cast<int16_t>(rule.greater ? rule.rating : -rule.rating),
+            rule.category, { resolve(static_cast<int32_t>(r) + 1), resolveWorkflow(rule.target) } };
+    }
+    program.start = resolveWorkflow(compiled.start);
+    return program;
+}
+
+// parts as four columns of ratings rather than a map each
+struct PartBatch {
+    std::array<std::vector<int16_t>, 4> ratings;
+
+    size_t size() const { return ratings[0].size(); }
+
+    void push_back(const std::array<int16_t, 4>& part) {
+        for (int i = 0; i < 4; i++) {
+            ratings[i].push_back(part[i]);
+        }
+    }
+
+    void push_back(const Part& part) {
+        push_back({ static_cast<int16_t>(part.stats.at('x')), static_cast<int16_t>(part.stats.at('m')),
+            static_cast<int16_t>(part.stats.at('a')), static_cast<int16_t>(part.stats.at('s')) });
+    }
+};
+
+struct SortedParts {
+    int64_t accepted = 0;
+    int64_t ratings = 0;  // x + m + a + s summed over the accepted parts
+};
+
+// runs the parts through the program a block at a time, every part in the block taking one step per
+// round. The steps are independent so their loads overlap, instead of one part's chain of lookups
+// waiting on each other, and the only branch left is whether anything in the block is still going.
+SortedParts sortParts(const DecisionProgram& program, const PartBatch& parts) {
+    constexpr size_t lanes = 32;
+    const DecisionNode* nodes = program.nodes.data();
+    const std::array<const int16_t*, 4> columns = { parts.ratings[0].data(), parts.ratings[1].data(), parts.ratings[2].data(), parts.ratings[3].data() };
+    SortedParts result;
+    std::array<int32_t, lanes> at;
+    for (size_t base = 0; base < parts.size(); base += lanes) {
+        const size_t count = std::min(lanes, parts.size() - base);
+        std::fill_n(at.begin(), count, program.start);
+        for (bool running = true; running;) {
+            running = false;
+            for (size_t l = 0; l < count; l++) {
+                const DecisionNode& node = nodes[at[l]];
+                const bool passed = node.sign * columns[node.category][base + l] > node.bound;
+                at[l] = node.next[passed];
+                running |= at[l] > DecisionProgram::reject;
+            }
+        }
+        for (size_t l = 0; l < count; l++) {
+            const int64_t accepted = (at[l] == DecisionProgram::accept);
+            result.accepted += accepted;
+            result.ratings += accepted * (columns[0][base + l] + columns[1][base + l] + columns[2][base + l] + columns[3][base + l]);
+        }
+    }
+    return result;
+}
+
+int64_t doTheThing(const std::string& input) {
+    const auto [workflows, parts] = parseInput(input);
+    PartBatch batch;
+    for (const Part& part : parts) {
+        batch.push_back(part);
+    }
+    return sortParts(compileDecisions(compileWorkflows(workflows)), batch).ratings;
+}
+
 const std::string sampleInput =
 R"(px{a<2006:qkq,m>2090:A,rfg}
 pv{a>1716:R,A}
@@ -1036,9 +1290,104 @@ ss{x<1714:hks,s>2485:A,R}
 )";
 
 TEST(Aoc19Test, puzzleInput_doTheThing) {
-    ASSERT_EQ(0, doTheThing(puzzleInput));
+    ASSERT_EQ(401674, doTheThing(puzzleInput));
 }
 
 TEST(Aoc19Test, puzzleInput_doTheThing2) {
-    ASSERT_EQ(0, doTheThing2(puzzleInput));
-}
\ No newline at end of file
+    ASSERT_EQ(134906204068564, doTheThing2(puzzleInput));
+}
+
+TEST(Aoc19Test, compileWorkflows_sample) {
+    const auto compiled = compileWorkflows(parseInput(sampleInput).first);
+    ASSERT_EQ(12, ssize(compiled.ruleStart));
+    ASSERT_EQ(compiled.rules.size(), compiled.ruleStart.back());
+    // in{s<1351:px,qqz}
+    const CompiledRule& first = compiled.rules[compiled.ruleStart[compiled.start]];
+    ASSERT_EQ(3, first.category);
+    ASSERT_FALSE(first.greater);
+    ASSERT_EQ(1351, first.rating);
+    ASSERT_EQ(-1, compiled.rules[compiled.ruleStart[compiled.start + 1] - 1].category);
+}
+
+TEST(Aoc19Test, acceptedCombinations_matchesSpans) {
+    ASSERT_EQ(spanCombinations(sampleInput), doTheThing2(sampleInput));
+    ASSERT_EQ(spanCombinations(puzzleInput), doTheThing2(puzzleInput));
+    const auto compiled = compileWorkflows(parseInput(sampleInput).first);
+    ASSERT_EQ(0, acceptedCombinations(compiled, { { 1, 1, 1, 1 }, { 0, 4000, 4000, 4000 } }));
+    ASSERT_EQ(1, acceptedCombinations(compiled, { { 787, 2655, 1222, 2876 }, { 787, 2655, 1222, 2876 } }));  // the first sample part
+}
+
+// lots of workflows: a complete binary tree named by index, each one splitting on a category and
+// handing both halves to its children, and the leaves accepting or rejecting
+std::string workflowTree(const int count) {
+    const auto name = [](int index) {
+        std::string result = "w";
+        for (index++; index > 0; index /= 26) {
+            result += static_cast<char>('a' + index % 26);
+        }
+        return result;
+    };
+    uint32_t seed = 12345;
+    std::string result;
+    for (int i = 0; i < count; i++) {
+        const auto child = [&](const int c) { return (c < count) ? name(c) : ((c % 3 == 0) ? "R" : "A"); };
+        seed = seed * 1664525u + 1013904223u;
+        const auto category = "xmas"[seed % 4];
+        const auto rating = 1 + (seed >> 8) % 3999;
+        const auto other = "xmas"[(seed >> 4) % 4];
+        result += (i == 0 ? std::string("in") : name(i)) + "{" + category + ((seed >> 20) % 2 ? ">" : "<") + std::to_string(rating) + ":" + child(2 * i + 1) + ","
+            + other + ">" + std::to_string(4000 - rating / 2) + ":" + child(2 * i + 2) + "," + child(2 * i + 2) + "}\n";
+    }
+    return result + "\n";
+}
+
+TEST(Aoc19Test, workflowTree_acceptedCombinations_matchesSpans) {
+    const auto input = workflowTree(20000);
+    ASSERT_EQ(20000, ssize(parseInput(input).first));
+    ASSERT_EQ(spanCombinations(input), doTheThing2(input));
+}
+// every rating uniformly from 1 to 4000
+PartBatch randomParts(const int count, uint32_t seed = 12345) {
+    PartBatch result;
+    for (int i = 0; i < count; i++) {
+        std::array<int16_t, 4> part;
+        for (auto& rating : part) {
+            seed = seed * 1664525u + 1013904223u;
+            rating = static_cast<int16_t>(1 + (seed >> 8) % 4000);
+        }
+        result.push_back(part);
+    }
+    return result;
+}
+
+TEST(Aoc19Test, sortParts_matchesShuntPart) {
+    ASSERT_EQ(shuntedRatings(sampleInput), doTheThing(sampleInput));
+    ASSERT_EQ(shuntedRatings(puzzleInput), doTheThing(puzzleInput));
+
+    for (const auto& input : { sampleInput, puzzleInput, workflowTree(2000) }) {
+        const auto workflows = parseInput(input).first;
+        const auto program = compileDecisions(compileWorkflows(workflows));
+        const auto parts = randomParts(3000);
+        SortedParts expected;
+        for (size_t i = 0; i < parts.size(); i++) {
+            const Part part{ .stats = {{'x', parts.ratings[0][i]}, {'m', parts.ratings[1][i]}, {'a', parts.ratings[2][i]}, {'s', parts.ratings[3][i]}} };
+            if (shuntPart(workflows, part, "in")) {
+                expected.accepted++;
+                expected.ratings += partValue(part);
+            }
+        }
+        const auto sorted = sortParts(program, parts);
+        ASSERT_EQ(expected.accepted, sorted.accepted);
+        ASSERT_EQ(expected.ratings, sorted.ratings);
+    }
+}
+
+TEST(Aoc19Test, compileDecisions_skipsCatchAllWorkflows) {
+    // bb and cc are only catch-alls, so in's failed branch goes straight to A
+    const auto program = compileDecisions(compileWorkflows(parseInput("in{x>10:R,bb}\nbb{cc}\ncc{A}\n\n").first));
+    ASSERT_EQ(3, ssize(program.nodes));
+    ASSERT_EQ(2, program.start);
+    ASSERT_EQ(DecisionProgram::accept, program.nodes[2].next[0]);
+    ASSERT_EQ(DecisionProgram::reject, program.nodes[2].next[1]);
+    ASSERT_EQ(DecisionProgram::accept, compileDecisions(compileWorkflows(parseInput("in{bb}\nbb{A}\n\n").first)).start);
+}
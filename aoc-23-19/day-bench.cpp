@@ -0,0 +1,36 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-19-test.cpp"
+
+#include <memory>
+
+#include "aoc-bench.h"
+
+void aoc_bench::registerDay() {
+	add("day19/doTheThing/sample", [] { return doTheThing(sampleInput); });
+	add("day19/doTheThing2/sample", [] { return doTheThing2(sampleInput); });
+	add("day19/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+	add("day19/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput); });
+	// same workflows, more parts. Part 2 never looks at the parts, so it only tracks parsing there
+	const auto split = puzzleInput.find("\n\n");
+	const auto workflows = puzzleInput.substr(0, split + 2);
+	const auto parts = std::string_view(puzzleInput).substr(split + 2);
+	for (const auto& [scale, suffix] : scales) {
+		const auto scaled = workflows + repeatRecords(parts, "\n", scale) + "\n";
+		add(std::string("day19/doTheThing/") + suffix, [scaled] { return doTheThing(scaled); });
+		add(std::string("day19/doTheThing2/") + suffix, [scaled] { return doTheThing2(scaled); });
+	}
+
+	add("day19/shuntedRatings/puzzle", [] { return shuntedRatings(puzzleInput); });
+	// 10^6 parts through the puzzle's workflows, already compiled and laid out, so it's purely sortParts
+	const auto program = compileDecisions(compileWorkflows(parseInput(puzzleInput).first));
+	const auto manyParts = std::make_shared<PartBatch>(randomParts(1000000));
+	add("day19/sortParts/1M", [program, manyParts] { return sortParts(program, *manyParts).ratings; });
+
+	add("day19/spanCombinations/puzzle", [] { return spanCombinations(puzzleInput); });
+	const auto compiled = compileWorkflows(parseInput(puzzleInput).first);
+	add("day19/acceptedCombinations/puzzle", [compiled] { return acceptedCombinations(compiled); });
+	// 10^5 workflows, counting only - parsing that many is its own benchmark above
+	const auto tree = compileWorkflows(parseInput(workflowTree(100000)).first);
+	add("day19/acceptedCombinations/tree100k", [tree] { return acceptedCombinations(tree); });
+}
@@ -1,8 +1,15 @@
 #include <gtest/gtest.h>
 
+#include <array>
+#include <bit>
+#include <limits>
 #include <map>
+#include <optional>
 #include <queue>
 #include <regex>
+#include <set>
+#include <span>
+#include <stdexcept>
 
 #include "pex.h"
 
@@ -20,17 +27,10 @@ using LivePulse = std::tuple<std::string, Pulse, std::string>;
 
 using SandSystemUPtr = std::unique_ptr<SandSystem>;
 
-int hack = 0;
-
 class SandSystem {
 public:
     void sendPulse(const std::string& source, const Pulse pulse, const std::string& destination) {
         //std::cout << source << " -" << (pulse == Pulse::Low ? "low" : "high") << "-> " << destination << std::endl;
-        if (destination == "rx") {
-            if (pulse == Pulse::Low) {
-                hack++;
-            }
-        }
         mLivePulses.push(LivePulse{ source, pulse, destination });
         if (pulse == Pulse::Low) {
             ++lowCount;
@@ -110,19 +110,6 @@ class ConjunctionModule : public Module {
             // Then, if it remembers high pulses for all inputs, it sends a low pulse; 
             // otherwise, it sends a high pulse.
             mLastInputs[source] = pulse;
-            if (name == "sq") {
-                if (pulse == Pulse::High) {// || mLastInputs[source] == Pulse::High) {  // second thing is "window closing"
-                    if (true) { //pCountIf(mLastInputs, [](let p) { return p.second == Pulse::High; }) >= 2) {
-                        std::cout << "Tick " << tick << ": " << name << " received " << ((pulse == Pulse::Low) ? "low" : "high") << " pulse from " << source << ". ";
-                        for (let& inputPair : mLastInputs) {
-                            std::cout << inputPair.first << ":" << ((inputPair.second == Pulse::Low) ? "low" : "high") << " ";
-                        }
-
-                        std::cout << std::endl;
-                    }
-                }
-            }
-
             let outPulse = pAllOf(mLastInputs, [](let pulse) {return pulse.second == Pulse::High; }) ?
                 Pulse::Low :
                 Pulse::High;
@@ -154,23 +141,21 @@ std::unique_ptr<Module> moduleFactory(const std::string& type, const std::string
     return result;
 }
 
-const std::string eraseWS(const std::string& src) {
-    std::string result = src;
+const std::string eraseWS(const std::string_view src) {
+    std::string result(src);
     result.erase(remove_if(result.begin(), result.end(), isspace), result.end());
     return result;
 }
 
 SandSystem SandSystem::parseInput(const std::string& input) {
     SandSystem sandSystem;
-    let lines = pSplit(input, '\n');
-    for(let &line : lines) {
+    for(let &line : pSplitView(input, '\n')) {
         const std::regex regex("([%&]?)([a-z]+) -> ([a-z, ]+)");
-        std::smatch match;
-        let result = std::regex_match(line, match, regex);
+        std::match_results<std::string_view::const_iterator> match;
+        let result = std::regex_match(line.begin(), line.end(), match, regex);
         assert(result);
         auto newModule = moduleFactory(match[1].str(), match[2].str());
-        let destinations = pSplit(match[3].str(), ',');
-        for(let &destination: destinations) {
+        for(let &destination: pSplitView(std::string_view(match[3].first, match[3].second), ',')) {
             let trimmedDest = eraseWS(destination);
             newModule->destinations.emplace_back(trimmedDest);
         }
@@ -203,20 +188,608 @@ std::tuple<SandSystemUPtr,int,int> SandSystem::process(SandSystemUPtr sSystem, c
     return { std::move(sSystem), lowCount, highCount };
 }
 
-int64_t doTheThing(const std::string& input) {
+// SandSystem compiled down to integers. Every module name gets a dense id up front and after that
+// it's all arrays: flip-flops are a bit each, a conjunction is a bitmask of which inputs last sent high
+// plus a count of them, and pulses go round a ring buffer as (destination, input slot, level) - the
+// slot being which of the destination's inputs it came in on, which is all a conjunction needs to know
+// about the source. Nothing allocates once it's built.
+class PulseNetwork {
+public:
+    struct Counts {
+        int64_t low = 0;
+        int64_t high = 0;
+    };
+
+    explicit PulseNetwork(const std::string& input) {
+        std::vector<std::pair<std::string_view, std::vector<std::string_view>>> outputs;
+        for (let line : pSplitView(input, '\n')) {
+            if (line.empty()) {
+                continue;
+            }
+            let arrow = line.find(" -> ");
+            assert(arrow != std::string_view::npos);
+            let kind = (line[0] == '%') ? Kind::FlipFlop : (line[0] == '&') ? Kind::Conjunction : Kind::Broadcast;
+            let name = line.substr(kind == Kind::Broadcast ? 0 : 1, arrow - (kind == Kind::Broadcast ? 0 : 1));
+            mKinds[intern(name)] = kind;
+            std::vector<std::string_view> destinations;
+            for (let destination : pSplitView(line.substr(arrow + 4), ',')) {
+                destinations.push_back(trim(destination));
+            }
+            outputs.emplace_back(name, std::move(destinations));
+        }
+
+        // destinations that never get a line of their own (rx, output) are sinks
+        std::vector<std::vector<int32_t>> targetIds(outputs.size());
+        for (size_t i = 0; i < outputs.size(); i++) {
+            for (let destination : outputs[i].second) {
+                targetIds[i].push_back(intern(destination));
+            }
+        }
+
+        mOutStart.assign(mKinds.size() + 1, 0);
+        for (size_t i = 0; i < outputs.size(); i++) {
+            mOutStart[moduleId(outputs[i].first) + 1] = static_cast<int32_t>(targetIds[i].size());
+        }
+        std::partial_sum(mOutStart.begin(), mOutStart.end(), mOutStart.begin());
+        mOut.resize(mOutStart.back());
+        mInputCount.assign(mKinds.size(), 0);
+        mInputs.assign(mKinds.size(), {});
+        for (size_t i = 0; i < outputs.size(); i++) {
+            let from = moduleId(outputs[i].first);
+            for (size_t j = 0; j < targetIds[i].size(); j++) {
+                let to = targetIds[i][j];
+                mOut[mOutStart[from] + j] = { to, mInputCount[to]++ };
+                mInputs[to].push_back(from);
+            }
+        }
+        for (size_t id = 0; id < mKinds.size(); id++) {
+            assert(mKinds[id] != Kind::Conjunction || mInputCount[id] <= 64);
+        }
+
+        mBroadcaster = moduleId("broadcaster");
+        assert(mBroadcaster >= 0);
+        mFlipFlops.assign((mKinds.size() + 63) / 64, 0);
+        mMemory.assign(mKinds.size(), 0);
+        mHighInputs.assign(mKinds.size(), 0);
+        mRing.resize(std::bit_ceil(std::max<size_t>(mOut.size() * 2, 64)));
+    }
+
+    // -1 if there's no such module
+    int32_t moduleId(const std::string_view name) const {
+        let found = mIds.find(name);
+        return (found == mIds.end()) ? -1 : found->second;
+    }
+
+    // who feeds id, in the order of the input slots
+    const std::vector<int32_t>& inputs(const int32_t id) const { return mInputs[id]; }
+
+    std::vector<int32_t> flipFlops() const {
+        std::vector<int32_t> result;
+        for (int32_t id = 0; id < static_cast<int32_t>(mKinds.size()); id++) {
+            if (mKinds[id] == Kind::FlipFlop) {
+                result.push_back(id);
+            }
+        }
+        return result;
+    }
+
+    // for starting somewhere other than all off
+    void setFlipFlop(const int32_t id, const bool on) {
+        assert(mKinds[id] == Kind::FlipFlop);
+        let bit = uint64_t(1) << (id % 64);
+        mFlipFlops[id / 64] = on ? (mFlipFlops[id / 64] | bit) : (mFlipFlops[id / 64] & ~bit);
+    }
+
+    // one push of the button, returns every pulse sent while it settles (the button's own included)
+    Counts press() {
+        const QueuedPulse button{ mBroadcaster, 0, false };
+        bool unused = false;
+        return propagate({ &button, 1 }, -1, 0, unused);
+    }
+
+    // a press that says whether sink was sent a low pulse along the way
+    bool pressWatching(const int32_t sink) {
+        assert(sink < 0 || mKinds[sink] == Kind::Sink);
+        const QueuedPulse button{ mBroadcaster, 0, false };
+        bool lowToSink = false;
+        propagate({ &button, 1 }, sink, 0, lowToSink);
+        return lowToSink;
+    }
+
+    // back to how it was built: everything off, every conjunction remembering low
+    void reset() {
+        std::fill(mFlipFlops.begin(), mFlipFlops.end(), 0);
+        std::fill(mMemory.begin(), mMemory.end(), 0);
+        std::fill(mHighInputs.begin(), mHighInputs.end(), 0);
+    }
+
+    // Fewest presses (from reset) until sink gets a low pulse, worked out rather than simulated.
+    // The sink has to hang off a single conjunction, and whatever feeds that conjunction has to split into
+    // sub-networks that only meet there. Each of those gets its own slice of the broadcaster's outputs and is
+    // pressed on its own (the conjunction soaking up its pulses) until its state repeats, noting the presses
+    // where all of its inputs to the conjunction were high at once. Lining those schedules up is CRT.
+    // Assumes that sub-networks firing in the same press fire together, i.e. they hold high long enough
+    // to overlap - true of these puzzles, where each one is a counter that resets in the press it fires.
+    // nullopt if the wiring isn't like that (or a sub-network doesn't repeat within maxPresses).
+    std::optional<int64_t> pressesUntilLowPulse(const std::string_view sink, const int64_t maxPresses = 1 << 20) const {
+        let sinkId = moduleId(sink);
+        if (sinkId < 0 || mInputs[sinkId].size() != 1) {
+            return std::nullopt;
+        }
+        let gate = mInputs[sinkId][0];
+        if (mKinds[gate] != Kind::Conjunction || mOutStart[gate + 1] - mOutStart[gate] != 1) {
+            return std::nullopt;
+        }
+
+        // flood from each of the broadcaster's outputs, stopping at the gate. Outputs whose floods touch
+        // are one sub-network, so each node remembers the first output to get there and they're unioned
+        let firstOut = mOutStart[mBroadcaster];
+        let outCount = mOutStart[mBroadcaster + 1] - firstOut;
+        std::vector<int32_t> reachedBy(mKinds.size(), -1);
+        std::vector<int32_t> parent(outCount);
+        std::iota(parent.begin(), parent.end(), 0);
+        let root = [&parent](int32_t i) {
+            while (parent[i] != i) {
+                i = parent[i] = parent[parent[i]];
+            }
+            return i;
+        };
+        for (int32_t i = 0; i < outCount; i++) {
+            let start = mOut[firstOut + i].to;
+            if (start == gate || start == sinkId) {
+                return std::nullopt;
+            }
+            std::vector<bool> visited(mKinds.size(), false);
+            std::vector<int32_t> stack{ start };
+            visited[start] = true;
+            while (!stack.empty()) {
+                let id = stack.back();
+                stack.pop_back();
+                if (reachedBy[id] < 0) {
+                    reachedBy[id] = i;
+                }
+                else {
+                    parent[root(reachedBy[id])] = root(i);
+                }
+                for (int32_t j = mOutStart[id]; j < mOutStart[id + 1]; j++) {
+                    let to = mOut[j].to;
+                    if (to == sinkId || to == mBroadcaster) {
+                        return std::nullopt;
+                    }
+                    if (to != gate && !visited[to]) {
+                        visited[to] = true;
+                        stack.push_back(to);
+                    }
+                }
+            }
+        }
+
+        std::vector<int32_t> owner(mKinds.size(), -1);
+        std::vector<int32_t> groupOf(outCount, -1);
+        std::vector<std::vector<int32_t>> members;
+        std::vector<std::vector<QueuedPulse>> starts;
+        for (int32_t i = 0; i < outCount; i++) {
+            if (groupOf[root(i)] < 0) {
+                groupOf[root(i)] = static_cast<int32_t>(members.size());
+                members.emplace_back();
+                starts.emplace_back();
+            }
+            let& first = mOut[firstOut + i];
+            starts[groupOf[root(i)]].push_back({ first.to, first.slot, false });
+        }
+        for (int32_t id = 0; id < static_cast<int32_t>(mKinds.size()); id++) {
+            if (reachedBy[id] >= 0) {
+                owner[id] = groupOf[root(reachedBy[id])];
+                members[owner[id]].push_back(id);
+            }
+        }
+
+        std::vector<uint64_t> gateMasks(members.size(), 0);
+        for (size_t slot = 0; slot < mInputs[gate].size(); slot++) {
+            let from = mInputs[gate][slot];
+            if (from == mBroadcaster || owner[from] < 0) {
+                return std::nullopt;  // an input nothing can ever drive high, or one that's only ever low
+            }
+            gateMasks[owner[from]] |= uint64_t(1) << slot;
+        }
+
+        PulseNetwork scratch = *this;
+        scratch.reset();
+        std::vector<PressSchedule> schedules;
+        for (size_t group = 0; group < members.size(); group++) {
+            if (gateMasks[group] == 0) {
+                continue;  // wired up but doesn't feed the gate, it can't matter
+            }
+            let schedule = scratch.isolatedSchedule(members[group], starts[group], gate, gateMasks[group], maxPresses);
+            if (!schedule) {
+                return std::nullopt;
+            }
+            schedules.push_back(*schedule);
+        }
+        return firstCommonPress(schedules);
+    }
+
+private:
+    friend class PulseBatch;
+
+    struct QueuedPulse {
+        int32_t to;
+        int32_t slot;
+        bool high;
+    };
+
+    // the presses one sub-network fires on: press p fires if it's in fires, where anything past
+    // cycleStart + cycleLength wraps back round by cycleLength (presses count from 1)
+    struct PressSchedule {
+        int64_t cycleStart = 0;
+        int64_t cycleLength = 0;
+        std::vector<int64_t> fires;
+
+        bool firesOn(int64_t press) const {
+            if (press > cycleStart + cycleLength) {
+                press = cycleStart + 1 + (press - cycleStart - 1) % cycleLength;
+            }
+            return std::binary_search(fires.begin(), fires.end(), press);
+        }
+    };
+
+    // a * b % m without overflowing, for moduli up near 2^62
+    static int64_t mulMod(int64_t a, int64_t b, const int64_t m) {
+        int64_t result = 0;
+        a %= m;
+        for (; b > 0; b >>= 1) {
+            if (b & 1) {
+                result = (result + a) % m;
+            }
+            a = (a + a) % m;
+        }
+        return result;
+    }
+
+    // x = r1 (mod m1) and x = r2 (mod m2) as a single x = r (mod lcm), nullopt if they never agree
+    static std::optional<std::pair<int64_t, int64_t>> crt(const int64_t r1, const int64_t m1, const int64_t r2, const int64_t m2) {
+        // extended euclid for m1 * inverse = g (mod m2)
+        int64_t oldR = m1, r = m2, oldS = 1, s = 0;
+        while (r != 0) {
+            let q = oldR / r;
+            oldR = std::exchange(r, oldR - q * r);
+            oldS = std::exchange(s, oldS - q * s);
+        }
+        let g = oldR;
+        if ((r2 - r1) % g != 0) {
+            return std::nullopt;
+        }
+        let step = m2 / g;
+        let lcm = m1 / g * m2;
+        let k = mulMod(((r2 - r1) / g % step + step) % step, (oldS % step + step) % step, step);
+        return std::pair{ ((r1 + mulMod(m1, k, lcm)) % lcm + lcm) % lcm, lcm };
+    }
+
+    static std::optional<int64_t> firstCommonPress(const std::vector<PressSchedule>& schedules) {
+        if (schedules.empty()) {
+            return std::nullopt;
+        }
+        let onAll = [&](const int64_t press) {
+            return pAllOf(schedules, [press](let& schedule) { return schedule.firesOn(press); });
+        };
+
+        // before every sub-network is into its cycle there's only a handful of presses to try
+        std::optional<int64_t> best;
+        for (let& schedule : schedules) {
+            for (let press : schedule.fires) {
+                if (press <= schedule.cycleStart && onAll(press) && (!best || press < *best)) {
+                    best = press;
+                }
+            }
+        }
+
+        // after that, every cycling fire is a residue and it's residue classes all the way down
+        int64_t lowest = 1;
+        std::vector<std::pair<int64_t, int64_t>> classes{ { 0, 1 } };
+        for (let& schedule : schedules) {
+            lowest = std::max(lowest, schedule.cycleStart + 1);
+            std::vector<std::pair<int64_t, int64_t>> combined;
+            for (let& [r, m] : classes) {
+                for (let press : schedule.fires) {
+                    if (press > schedule.cycleStart) {
+                        if (let merged = crt(r, m, press % schedule.cycleLength, schedule.cycleLength)) {
+                            combined.push_back(*merged);
+                        }
+                    }
+                }
+            }
+            classes = std::move(combined);
+        }
+        for (let& [r, m] : classes) {
+            let press = lowest + ((r - lowest) % m + m) % m;
+            if (!best || press < *best) {
+                best = press;
+            }
+        }
+        return best;
+    }
+
+    // presses just this sub-network (starting from its share of the broadcaster's pulses) until its
+    // flip-flops and conjunctions are somewhere they've been before. gate takes its pulses but sends nothing
+    std::optional<PressSchedule> isolatedSchedule(const std::vector<int32_t>& members, const std::vector<QueuedPulse>& starts,
+        const int32_t gate, const uint64_t gateMask, const int64_t maxPresses) {
+        let snapshot = [&] {
+            std::vector<uint64_t> state((members.size() + 63) / 64, 0);
+            for (size_t i = 0; i < members.size(); i++) {
+                let id = members[i];
+                if (mKinds[id] == Kind::FlipFlop && ((mFlipFlops[id / 64] >> (id % 64)) & 1)) {
+                    state[i / 64] |= uint64_t(1) << (i % 64);
+                }
+                else if (mKinds[id] == Kind::Conjunction) {
+                    state.push_back(mMemory[id]);
+                }
+            }
+            state.push_back(mMemory[gate] & gateMask);
+            return state;
+        };
+
+        PressSchedule schedule;
+        std::map<std::vector<uint64_t>, int64_t> seen{ { snapshot(), 0 } };
+        for (int64_t press = 1; press <= maxPresses; press++) {
+            bool fired = false;
+            propagate(starts, gate, gateMask, fired);
+            if (fired) {
+                schedule.fires.push_back(press);
+            }
+            let [found, inserted] = seen.try_emplace(snapshot(), press);
+            if (!inserted) {
+                schedule.cycleStart = found->second;
+                schedule.cycleLength = press - found->second;
+                return schedule;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // runs pulses until everything settles. If hold is a conjunction a pulse into it only updates its memory,
+    // nothing goes out of it, and fired gets set if that ever leaves all of holdMask's inputs high. If hold is
+    // a sink fired gets set when it's sent a low pulse
+    Counts propagate(const std::span<const QueuedPulse> firstPulses, const int32_t hold, const uint64_t holdMask, bool& fired) {
+        Counts counts;
+        mHead = 0;
+        mTail = 0;
+        for (let& pulse : firstPulses) {
+            push(pulse);
+        }
+        while (mHead != mTail) {
+            let pulse = mRing[mHead++ & (mRing.size() - 1)];
+            (pulse.high ? counts.high : counts.low)++;
+            bool out;
+            switch (mKinds[pulse.to]) {
+            case Kind::Broadcast:
+                out = pulse.high;
+                break;
+            case Kind::FlipFlop: {
+                if (pulse.high) {
+                    continue;
+                }
+                auto& word = mFlipFlops[pulse.to / 64];
+                word ^= uint64_t(1) << (pulse.to % 64);
+                out = (word >> (pulse.to % 64)) & 1;
+                break;
+            }
+            case Kind::Conjunction: {
+                let bit = uint64_t(1) << pulse.slot;
+                if (pulse.high != ((mMemory[pulse.to] & bit) != 0)) {
+                    mMemory[pulse.to] ^= bit;
+                    mHighInputs[pulse.to] += pulse.high ? 1 : -1;
+                }
+                if (pulse.to == hold) {
+                    fired = fired || (mMemory[pulse.to] & holdMask) == holdMask;
+                    continue;
+                }
+                out = mHighInputs[pulse.to] != mInputCount[pulse.to];
+                break;
+            }
+            default:
+                // a sink, it only matters if it's the one being watched
+                fired = fired || (pulse.to == hold && !pulse.high);
+                continue;
+            }
+            for (int32_t i = mOutStart[pulse.to]; i < mOutStart[pulse.to + 1]; i++) {
+                push({ mOut[i].to, mOut[i].slot, out });
+            }
+        }
+        return counts;
+    }
+
+    enum class Kind : uint8_t {
+        Sink,
+        Broadcast,
+        FlipFlop,
+        Conjunction
+    };
+
+    struct Target {
+        int32_t to;
+        int32_t slot;
+    };
+
+    static std::string_view trim(std::string_view str) {
+        while (!str.empty() && isspace(static_cast<unsigned char>(str.front()))) str.remove_prefix(1);
+        while (!str.empty() && isspace(static_cast<unsigned char>(str.back()))) str.remove_suffix(1);
+        return str;
+    }
+
+    int32_t intern(const std::string_view name) {
+        if (let found = mIds.find(name); found != mIds.end()) {
+            return found->second;
+        }
+        mKinds.push_back(Kind::Sink);
+        return mIds.emplace(std::string(name), static_cast<int32_t>(mKinds.size() - 1)).first->second;
+    }
+
+    void push(const QueuedPulse& pulse) {
+        if (mTail - mHead == mRing.size()) {
+            // never happens on the real thing, but a ring that's full just gets twice as big
+            std::vector<QueuedPulse> bigger(mRing.size() * 2);
+            for (size_t i = 0; i < mRing.size(); i++) {
+                bigger[i] = mRing[(mHead + i) & (mRing.size() - 1)];
+            }
+            mTail -= mHead;
+            mHead = 0;
+            mRing = std::move(bigger);
+        }
+        mRing[mTail++ & (mRing.size() - 1)] = pulse;
+    }
+
+    std::map<std::string, int32_t, std::less<>> mIds;
+    std::vector<Kind> mKinds;
+    std::vector<int32_t> mOutStart;
+    std::vector<Target> mOut;
+    std::vector<int32_t> mInputCount;
+    std::vector<std::vector<int32_t>> mInputs;
+    int32_t mBroadcaster = -1;
+
+    std::vector<uint64_t> mFlipFlops;
+    std::vector<uint64_t> mMemory;
+    std::vector<int32_t> mHighInputs;
+    std::vector<QueuedPulse> mRing;
+    size_t mHead = 0;
+    size_t mTail = 0;
+};
+
+// 64 copies of one PulseNetwork pressed in lockstep, one per bit of a uint64_t. Every module's state is a
+// lane word - flip-flops one word each, conjunctions a word per input - so a toggle or an "all inputs high"
+// is a handful of bitwise ops for every copy at once. A queued pulse carries which lanes it's live in and
+// which of those it's high in; a copy's own pulses come out of the ring in exactly the order they would
+// on their own, the ones it isn't live in just aren't there for it. The low/high counts are kept per lane
+// as bit-sliced counters so adding a pulse to every lane it touched stays bitwise too.
+// Only the wiring comes from the network (which has to outlive the batch), not its state.
+class PulseBatch {
+public:
+    static constexpr int lanes = 64;
+
+    explicit PulseBatch(const PulseNetwork& network)
+        : mNetwork(network), mFlipFlops(network.mKinds.size(), 0), mSlotStart(network.mKinds.size() + 1, 0) {
+        std::partial_sum(network.mInputCount.begin(), network.mInputCount.end(), mSlotStart.begin() + 1);
+        mMemory.assign(mSlotStart.back(), 0);
+        mRing.resize(network.mRing.size());
+    }
+
+    // every lane starts as a fresh network, this puts one of them somewhere else
+    void setFlipFlop(const int lane, const int32_t id, const bool on) {
+        assert(mNetwork.mKinds[id] == PulseNetwork::Kind::FlipFlop);
+        let bit = uint64_t(1) << lane;
+        mFlipFlops[id] = on ? (mFlipFlops[id] | bit) : (mFlipFlops[id] & ~bit);
+    }
+
+    void press() {
+        mHead = 0;
+        mTail = 0;
+        push({ mNetwork.mBroadcaster, 0, ~uint64_t(0), 0 });
+        while (mHead != mTail) {
+            let pulse = mRing[mHead++ & (mRing.size() - 1)];
+            add(mHigh, pulse.live & pulse.high);
+            add(mLow, pulse.live & ~pulse.high);
+            uint64_t live;
+            uint64_t high;
+            switch (mNetwork.mKinds[pulse.to]) {
+            case PulseNetwork::Kind::Broadcast:
+                live = pulse.live;
+                high = pulse.high;
+                break;
+            case PulseNetwork::Kind::FlipFlop:
+                live = pulse.live & ~pulse.high;
+                mFlipFlops[pulse.to] ^= live;
+                high = mFlipFlops[pulse.to] & live;
+                break;
+            case PulseNetwork::Kind::Conjunction: {
+                let first = mSlotStart[pulse.to];
+                auto& memory = mMemory[first + pulse.slot];
+                memory = (memory & ~pulse.live) | (pulse.high & pulse.live);
+                uint64_t allHigh = ~uint64_t(0);
+                for (int32_t i = first; i < mSlotStart[pulse.to + 1]; i++) {
+                    allHigh &= mMemory[i];
+                }
+                live = pulse.live;
+                high = ~allHigh & live;
+                break;
+            }
+            default:
+                continue;
+            }
+            if (live == 0) {
+                continue;
+            }
+            for (int32_t i = mNetwork.mOutStart[pulse.to]; i < mNetwork.mOutStart[pulse.to + 1]; i++) {
+                push({ mNetwork.mOut[i].to, mNetwork.mOut[i].slot, live, high });
+            }
+        }
+    }
+
+    // everything lane has sent since it was built, the same totals its own PulseNetwork would give
+    PulseNetwork::Counts counts(const int lane) const {
+        return { total(mLow, lane), total(mHigh, lane) };
+    }
+
+private:
+    struct QueuedLanes {
+        int32_t to;
+        int32_t slot;
+        uint64_t live;
+        uint64_t high;
+    };
+
+    // bit i of planes[b] is bit b of lane i's count
+    static constexpr int countBits = 48;
+    using SlicedCounter = std::array<uint64_t, countBits>;
+
+    static void add(SlicedCounter& planes, uint64_t carry) {
+        for (int b = 0; carry != 0; b++) {
+            assert(b < countBits);
+            let next = planes[b] & carry;
+            planes[b] ^= carry;
+            carry = next;
+        }
+    }
+
+    static int64_t total(const SlicedCounter& planes, const int lane) {
+        int64_t result = 0;
+        for (int b = 0; b < countBits; b++) {
+            result |= static_cast<int64_t>((planes[b] >> lane) & 1) << b;
+        }
+        return result;
+    }
+
+    void push(const QueuedLanes& pulse) {
+        if (mTail - mHead == mRing.size()) {
+            std::vector<QueuedLanes> bigger(mRing.size() * 2);
+            for (size_t i = 0; i < mRing.size(); i++) {
+                bigger[i] = mRing[(mHead + i) & (mRing.size() - 1)];
+            }
+            mTail -= mHead;
+            mHead = 0;
+            mRing = std::move(bigger);
+        }
+        mRing[mTail++ & (mRing.size() - 1)] = pulse;
+    }
+
+    const PulseNetwork& mNetwork;
+    std::vector<uint64_t> mFlipFlops;  // by module id, the bit is the lane
+    std::vector<int32_t> mSlotStart;   // a conjunction's input words are mMemory[mSlotStart[id]...mSlotStart[id + 1]]
+    std::vector<uint64_t> mMemory;
+    SlicedCounter mLow{};
+    SlicedCounter mHigh{};
+    std::vector<QueuedLanes> mRing;
+    size_t mHead = 0;
+    size_t mTail = 0;
+};
+
+// the original, string keyed all the way down. kept to check PulseNetwork against
+int64_t sandSystemPresses(const std::string& input, const int64_t presses) {
     auto sandSystem = std::make_unique<SandSystem>(SandSystem::parseInput(input));
 
-    int lowSum = 0;
-    int highSum = 0;
-    for (int64_t i = 0; i < 1000; i++) {
-        // press the button
-        //std::cout << i << std::endl;
+    int64_t lowSum = 0;
+    int64_t highSum = 0;
+    for (int64_t i = 0; i < presses; i++) {
         sandSystem->sendPulse("button", Pulse::Low, "broadcaster");
         auto [sandSystemRet, low, high] = SandSystem::process(std::move(sandSystem), i);
-        if (hack > 0) {
-            std::cout << "rx tagged at " << i << std::endl;
-            break;
-        }
         sandSystem = std::move(sandSystemRet);
         lowSum += low;
         highSum += high;
@@ -224,25 +797,41 @@ int64_t doTheThing(const std::string& input) {
     return lowSum * highSum;
 }
 
-int64_t doTheThing2(const std::string& input) {
-    auto sandSystem = std::make_unique<SandSystem>(SandSystem::parseInput(input));
+int64_t doTheThing(const std::string& input) {
+    PulseNetwork network(input);
+    int64_t lowSum = 0;
+    int64_t highSum = 0;
+    for (int64_t i = 0; i < 1000; i++) {
+        let counts = network.press();
+        lowSum += counts.low;
+        highSum += counts.high;
+    }
+    return lowSum * highSum;
+}
 
-    int lowSum = 0;
-    int highSum = 0;
-    for (int64_t i = 0; ; i++) {
-        // press the button
-        //std::cout << i << std::endl;
-        sandSystem->sendPulse("button", Pulse::Low, "broadcaster");
-        auto [sandSystemRet, low, high] = SandSystem::process(std::move(sandSystem), i);
-        if (hack > 0) {
-            std::cout << "rx tagged at " << i << std::endl;
-            break;
+// the same by pressing until it happens, for networks where that's quick (or the analysis gives up).
+// Takes its own copy of the network, since pressing it changes it
+int64_t pressesBySimulation(PulseNetwork network, const std::string_view sink, const int64_t maxPresses) {
+    let sinkId = network.moduleId(sink);
+    for (int64_t press = 1; press <= maxPresses; press++) {
+        if (network.pressWatching(sinkId)) {
+            return press;
         }
-        sandSystem = std::move(sandSystemRet);
-        lowSum += low;
-        highSum += high;
     }
-    return lowSum * highSum;
+    return -1;
+}
+
+// fewest presses before rx gets a low pulse. Networks the cycle analysis doesn't understand just get
+// pressed until it happens, however long that takes. No rx at all means there's nothing to wait for
+int64_t doTheThing2(const std::string& input) {
+    const PulseNetwork network(input);
+    if (network.moduleId("rx") < 0) {
+        throw std::invalid_argument("no rx module in this network");
+    }
+    if (let presses = network.pressesUntilLowPulse("rx")) {
+        return *presses;
+    }
+    return pressesBySimulation(network, "rx", std::numeric_limits<int64_t>::max());
 }
 
 TEST(Aoc20Tests, TestTest) {
@@ -335,9 +924,144 @@ broadcaster -> gd, kg, gt, lf
 )";
 
 TEST(Aoc20Tests, puzzleInput_doTheThing) {
-    ASSERT_EQ(0, doTheThing(puzzleInput));
+    ASSERT_EQ(867118762, doTheThing(puzzleInput));
+}
+
+TEST(Aoc20Tests, pulseNetwork_matchesSandSystem) {
+    for (let& input : { sample1, sample2, puzzleInput }) {
+        for (let presses : { 1, 7, 1000, 4000 }) {
+            PulseNetwork network(input);
+            int64_t lowSum = 0;
+            int64_t highSum = 0;
+            for (int i = 0; i < presses; i++) {
+                let counts = network.press();
+                lowSum += counts.low;
+                highSum += counts.high;
+            }
+            ASSERT_EQ(sandSystemPresses(input, presses), lowSum * highSum);
+        }
+    }
+}
+
+TEST(Aoc20Tests, pulseNetwork_conjunctionInputsInSlotOrder) {
+    PulseNetwork network(sample2);
+    let con = network.moduleId("con");
+    ASSERT_EQ((std::vector<int32_t>{ network.moduleId("a"), network.moduleId("b") }), network.inputs(con));
+    ASSERT_EQ(-1, network.moduleId("nope"));
+}
+
+TEST(Aoc20Tests, pulseBatch_everyLaneMatchesSandSystem) {
+    for (let& input : { sample1, sample2, puzzleInput }) {
+        PulseNetwork network(input);
+        PulseBatch batch(network);
+        for (int i = 0; i < 1000; i++) {
+            batch.press();
+        }
+        let expected = sandSystemPresses(input, 1000);
+        for (int lane = 0; lane < PulseBatch::lanes; lane++) {
+            let counts = batch.counts(lane);
+            ASSERT_EQ(expected, counts.low * counts.high);
+        }
+    }
+}
+
+TEST(Aoc20Tests, pulseBatch_lanesFromDifferentStarts) {
+    const PulseNetwork network(puzzleInput);
+    let flipFlops = network.flipFlops();
+    PulseBatch batch(network);
+    std::vector<PulseNetwork> singles(PulseBatch::lanes, network);
+    uint32_t seed = 12345;
+    for (int lane = 0; lane < PulseBatch::lanes; lane++) {
+        for (let id : flipFlops) {
+            seed = seed * 1664525u + 1013904223u;
+            let on = lane > 0 && (seed >> 31) != 0;  // lane 0 stays all off
+            batch.setFlipFlop(lane, id, on);
+            singles[lane].setFlipFlop(id, on);
+        }
+    }
+    std::vector<PulseNetwork::Counts> expected(PulseBatch::lanes);
+    for (int i = 0; i < 500; i++) {
+        batch.press();
+        for (int lane = 0; lane < PulseBatch::lanes; lane++) {
+            let counts = singles[lane].press();
+            expected[lane].low += counts.low;
+            expected[lane].high += counts.high;
+        }
+    }
+    std::set<int64_t> distinct;
+    for (int lane = 0; lane < PulseBatch::lanes; lane++) {
+        ASSERT_EQ(expected[lane].low, batch.counts(lane).low);
+        ASSERT_EQ(expected[lane].high, batch.counts(lane).high);
+        distinct.insert(expected[lane].low);
+    }
+    ASSERT_LT(1, distinct.size());  // or the lanes weren't really doing different things
 }
 
 TEST(Aoc20Tests, puzzleInput_doTheThing2) {
-    ASSERT_EQ(0, doTheThing2(puzzleInput));
+    ASSERT_EQ(217317393039529, doTheThing2(puzzleInput));
+}
+
+// the same shape as the puzzle, but small enough to press through: one flip-flop chain per period counting
+// up in binary, a hub conjunction on the bits that are set in the period which resets the rest, and an
+// inverter from each hub into the gate in front of rx
+std::string counterNetwork(const std::vector<int>& periods) {
+    std::string broadcaster = "broadcaster -> ";
+    std::string modules;
+    std::string gateInputs;
+    for (size_t c = 0; c < periods.size(); c++) {
+        let bits = static_cast<int>(std::bit_width(static_cast<unsigned>(periods[c])));
+        let name = [c](let kind, let i) { return std::string(1, kind) + std::string(1, char('a' + c)) + std::to_string(i); };
+        broadcaster += (c ? ", " : "") + name('f', 0);
+        std::string hubOutputs = name('i', 0);
+        for (int i = 0; i < bits; i++) {
+            modules += "%" + name('f', i) + " -> " + ((i + 1 < bits) ? name('f', i + 1) + ", " : "");
+            if ((periods[c] >> i) & 1) {
+                modules += name('h', 0) + "\n";
+            }
+            else {
+                modules.erase(modules.size() - 2);
+                modules += "\n";
+            }
+            if (!((periods[c] >> i) & 1) || i == 0) {
+                hubOutputs += ", " + name('f', i);
+            }
+        }
+        modules += "&" + name('h', 0) + " -> " + hubOutputs + "\n";
+        modules += "&" + name('i', 0) + " -> gate\n";
+    }
+    return broadcaster + "\n" + modules + "&gate -> rx\n";
+}
+
+TEST(Aoc20Tests, pressesUntilLowPulse_matchesPressingIt) {
+    for (let& periods : std::vector<std::vector<int>>{ { 3 }, { 3, 5 }, { 3, 5, 7 }, { 9, 15 }, { 11, 13, 7 }, { 21, 35, 15 } }) {
+        let input = counterNetwork(periods);
+        let expected = pressesBySimulation(PulseNetwork(input), "rx", 10000);
+        ASSERT_LT(0, expected);
+        ASSERT_EQ(expected, PulseNetwork(input).pressesUntilLowPulse("rx"));
+    }
+}
+
+TEST(Aoc20Tests, pressesUntilLowPulse_givesUpOnOtherShapes) {
+    ASSERT_FALSE(PulseNetwork(sample1).pressesUntilLowPulse("rx"));  // no rx at all
+    ASSERT_FALSE(PulseNetwork(sample2).pressesUntilLowPulse("con"));  // not a sink
+    ASSERT_FALSE(PulseNetwork("broadcaster -> a\n%a -> gate\n&gate -> rx, a\n").pressesUntilLowPulse("rx"));  // the gate feeds back
+}
+
+TEST(Aoc20Tests, doTheThing2_simulatesWhatTheAnalysisGivesUpOn) {
+    const std::string feedback = "broadcaster -> a\n%a -> gate\n&gate -> rx, a\n";
+    ASSERT_EQ(pressesBySimulation(PulseNetwork(feedback), "rx", 1000), doTheThing2(feedback));
+    ASSERT_THROW(doTheThing2(sample1), std::invalid_argument);
+}
+
+TEST(Aoc20Tests, sample2_pressesUntilLowPulse) {
+    // a and b both feed con, one sub-network with two inputs into the gate
+    ASSERT_EQ(pressesBySimulation(PulseNetwork(sample2), "output", 1000), PulseNetwork(sample2).pressesUntilLowPulse("output"));
+}
+
+TEST(Aoc20Tests, pressesUntilLowPulse_overlappingSubNetworks) {
+    // both of the broadcaster's outputs end up in c, so they're pressed as one
+    const std::string input = "broadcaster -> a, b\n%a -> c\n%b -> c\n%c -> d\n&d -> gate\n%e -> gate\n&gate -> rx\n";
+    ASSERT_FALSE(PulseNetwork(input).pressesUntilLowPulse("rx"));  // e is never pressed, so never high
+    const std::string joined = "broadcaster -> a, b, e\n%a -> c\n%b -> c\n%c -> d\n&d -> gate\n%e -> f\n%f -> g\n&g -> gate\n&gate -> rx\n";
+    ASSERT_EQ(pressesBySimulation(PulseNetwork(joined), "rx", 1000), PulseNetwork(joined).pressesUntilLowPulse("rx"));
 }
@@ -0,0 +1,28 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-20-test.cpp"
+
+#include <memory>
+
+#include "aoc-bench.h"
+
+// no synthetic sizes, the work is 1000 button presses whatever the wiring is, and doTheThing2 is
+// a few thousand presses per sub-network however far away the answer is.
+void aoc_bench::registerDay() {
+	add("day20/doTheThing/sample1", [] { return doTheThing(sample1); });
+	add("day20/doTheThing/sample2", [] { return doTheThing(sample2); });
+	add("day20/doTheThing/puzzle", [] { return doTheThing(puzzleInput); });
+	add("day20/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput); });
+	add("day20/sandSystemPresses/puzzle", [] { return sandSystemPresses(puzzleInput, 1000); });
+
+	// one press per iteration on a network that keeps its state between them, so ns/op is per press
+	const auto network = std::make_shared<PulseNetwork>(puzzleInput);
+	add("day20/PulseNetwork::press/puzzle", [network] { return network->press().low; });
+
+	// 64 presses per iteration, one in each lane
+	const auto batch = std::make_shared<PulseBatch>(*network);
+	add("day20/PulseBatch::press/puzzle", [network, batch] {
+		batch->press();
+		return batch->counts(0).low;
+	});
+}
@@ -3,8 +3,10 @@
 #include "pex.h"
 
 #include <array>
+#include <bit>
 #include <queue>
 #include <limits>
+#include <map>
 
 using namespace pex;
 
@@ -97,73 +99,116 @@ enum class CompassDir {
 	Back = W
 };
 
-static Vec2 compassOffsets[] = {{-1,-1}, {0,-1}, {1,-1}, {1,0}, {1,1}, {0,1}, {-1,1}, {-1,0}};
-
 bool isCardinal(const CompassDir direction) {
 	return static_cast<int>(direction) % 2 == 1;
 }
 
-constexpr int64_t maxDistance = 300;
+// how many plots sit at each distance from one source within a single tile, kept as landing counts
+struct DistanceHistogram {
+	std::vector<int64_t> cumulative;  // [d] = plots at distance d, d-2, d-4... down to 0 or 1
 
-using MemoArray = std::vector<std::vector<int64_t>>;
+	// plots you can finish on with remaining steps left, the same as validLandingPointsForSubgrid
+	int64_t landing(const int64_t remaining) const {
+		if (remaining < 0 || cumulative.empty()) {
+			return 0;
+		}
+		cauto last = std::ssize(cumulative) - 1;
+		// everything's reached, just keep the parity
+		cauto d = (remaining <= last) ? remaining : (last - ((last - remaining) % 2 != 0 ? 1 : 0));
+		return d < 0 ? 0 : cumulative[d];
+	}
 
-int64_t validLandingPointsForSubgrids(MemoArray& memoArray, const Grid<char>& grid, const CompassDir incomingDirection, int64_t distance) {
-	if (distance <= 0) {
-		return 0;
+	int64_t maxDistance() const { return std::ssize(cumulative) - 1; }
+};
+
+DistanceHistogram distanceHistogram(const Grid<bool>& rocks, const Vec2& source) {
+	DistanceHistogram histogram;
+	if (!inBounds(rocks, source) || rocks[source.y][source.x]) {
+		return histogram;
 	}
-	cauto choppedDistance = std::min(maxDistance-1, distance);
-	if (memoArray[static_cast<int>(incomingDirection)][choppedDistance]>=0) {
-		return memoArray[static_cast<int>(incomingDirection)][choppedDistance];
+	auto seen = createGrid<bool>(gridWidth(rocks), gridHeight(rocks), false);
+	std::vector<Vec2> frontier{ source };
+	seen[source.y][source.x] = true;
+	for (; !frontier.empty();) {
+		histogram.cumulative.push_back(std::ssize(frontier));
+		std::vector<Vec2> next;
+		for (cauto& at : frontier) {
+			for (cauto& step : { Vec2{ 1, 0 }, Vec2{ -1, 0 }, Vec2{ 0, 1 }, Vec2{ 0, -1 } }) {
+				cauto to = at + step;
+				if (inBounds(rocks, to) && !rocks[to.y][to.x] && !seen[to.y][to.x]) {
+					seen[to.y][to.x] = true;
+					next.push_back(to);
+				}
+			}
+		}
+		frontier = std::move(next);
 	}
-	cauto startCell =
+	for (size_t d = 2; d < histogram.cumulative.size(); d++) {
+		histogram.cumulative[d] += histogram.cumulative[d - 2];
+	}
+	return histogram;
+}
+
+Vec2 subgridEntry(const Grid<char>& grid, const CompassDir incomingDirection) {
+	return
 		(incomingDirection == CompassDir::NW) ? Vec2{ 0,0 } :
 		(incomingDirection == CompassDir::N) ? Vec2{ gridWidth(grid) / 2, 0 } :
 		(incomingDirection == CompassDir::NE) ? Vec2{ gridWidth(grid) - 1, 0 } :
 		(incomingDirection == CompassDir::E) ? Vec2{ gridWidth(grid) - 1, gridHeight(grid) / 2 } :
-		(incomingDirection == CompassDir::SE) ? Vec2{ gridWidth(grid), gridHeight(grid) } :
+		(incomingDirection == CompassDir::SE) ? Vec2{ gridWidth(grid) - 1, gridHeight(grid) - 1 } :
 		(incomingDirection == CompassDir::S) ? Vec2{ gridWidth(grid) / 2, gridHeight(grid) - 1 } :
 		(incomingDirection == CompassDir::SW) ? Vec2{ 0, gridHeight(grid) - 1 } :
 		(incomingDirection == CompassDir::W) ? Vec2{ 0, gridHeight(grid) / 2 } :
 		Vec2{ -1,-1 };
-	//assert(Vec2{ -1,-1 } != startCell);
+}
 
+// Landing points in the subgrid entered from incomingDirection plus every subgrid beyond it: cardinals
+// carry straight on, diagonals branch three ways. This used to be a memoized recursion, which meant a
+// full flood fill of the tile on every cache miss, a memo that clamped everything past 300 steps to the
+// same entry, and ~200k calls deep on the real distances. Now every direction's tile is flood filled once
+// into a histogram and the answers are built up from distance 1, for all 8 directions at once. Nothing
+// looks back further than one width plus one height, so that's all the table keeps (rounded up to a
+// power of two to index it with a mask).
+int64_t validLandingPointsForSubgrids(const Grid<char>& grid, const CompassDir incomingDirection, const int64_t distance) {
+	if (distance <= 0) {
+		return 0;
+	}
+	constexpr int directions = static_cast<int>(CompassDir::Back) + 1;
+	cauto rocks = gridTransform<bool>(grid, [](cauto cell) { return cell == '#'; });
+	std::array<DistanceHistogram, directions> tiles;
+	for (int dir = 0; dir < directions; dir++) {
+		tiles[dir] = distanceHistogram(rocks, subgridEntry(grid, static_cast<CompassDir>(dir)));
+	}
 
 	// be really easy to have off-by-one errors here. To make sure we don't imagine 3x3 subgrids
 	// It's 5 steps from off map to opposite corner; 4 steps from off map to orthogonal. 
 	// Imagine 5x5 : it's 9 and 7 (height+width-1 and height+width/2)
-	int64_t result = validLandingPointsForSubgrid(grid, startCell, distance);
-
-	if (incomingDirection == CompassDir::NW) {
-		// diagonals have to branch three ways
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::W, distance - gridWidth(grid) - gridHeight(grid) / 2);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::NW, distance - gridWidth(grid) - gridHeight(grid) - 1);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::N, distance - gridWidth(grid) / 2 - gridHeight(grid));
-	}
-	else if (incomingDirection == CompassDir::NE) {
-		// diagonals have to branch three ways
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::E, distance - gridWidth(grid) - gridHeight(grid) / 2);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::NE, distance - gridWidth(grid) - gridHeight(grid) - 1);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::N, distance - gridWidth(grid) / 2 - gridHeight(grid));
-	}
-	else if (incomingDirection == CompassDir::SE) {
-		// diagonals have to branch three ways
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::E, distance - gridWidth(grid) - gridHeight(grid) / 2);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::SE, distance - gridWidth(grid) - gridHeight(grid) - 1);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::S, distance - gridWidth(grid) / 2 - gridHeight(grid));
-	}
-	else if (incomingDirection == CompassDir::SW) {
-		// diagonals have to branch three ways
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::W, distance - gridWidth(grid) - gridHeight(grid) / 2);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::SW, distance - gridWidth(grid) - gridHeight(grid) - 1);
-		result += validLandingPointsForSubgrids(memoArray, grid, CompassDir::S, distance - gridWidth(grid) / 2 - gridHeight(grid));
-	}
-	else {
+	cauto width = gridWidth(grid);
+	cauto height = gridHeight(grid);
+	cauto toSide = width + height / 2;
+	cauto toCorner = width + height + 1;
+	cauto toEnd = width / 2 + height;
+	cauto window = static_cast<int64_t>(std::bit_ceil(static_cast<uint64_t>(toCorner + 1)));
+	std::vector<std::array<int64_t, directions>> table(window);
+	cauto earlier = [&](const CompassDir dir, const int64_t d) {
+		return d <= 0 ? 0 : table[d & (window - 1)][static_cast<int>(dir)];
+	};
+	for (int64_t d = 1; d <= distance; d++) {
+		auto& row = table[d & (window - 1)];
+		for (int dir = 0; dir < directions; dir++) {
+			row[dir] = tiles[dir].landing(d);
+		}
 		// cardinal directions are all straight shots
-		result += validLandingPointsForSubgrids(memoArray, grid, incomingDirection, distance - gridWidth(grid));
+		for (cauto dir : { CompassDir::N, CompassDir::E, CompassDir::S, CompassDir::W }) {
+			row[static_cast<int>(dir)] += earlier(dir, d - width);
+		}
+		// diagonals have to branch three ways
+		row[static_cast<int>(CompassDir::NW)] += earlier(CompassDir::W, d - toSide) + earlier(CompassDir::NW, d - toCorner) + earlier(CompassDir::N, d - toEnd);
+		row[static_cast<int>(CompassDir::NE)] += earlier(CompassDir::E, d - toSide) + earlier(CompassDir::NE, d - toCorner) + earlier(CompassDir::N, d - toEnd);
+		row[static_cast<int>(CompassDir::SE)] += earlier(CompassDir::E, d - toSide) + earlier(CompassDir::SE, d - toCorner) + earlier(CompassDir::S, d - toEnd);
+		row[static_cast<int>(CompassDir::SW)] += earlier(CompassDir::W, d - toSide) + earlier(CompassDir::SW, d - toCorner) + earlier(CompassDir::S, d - toEnd);
 	}
-
-	memoArray[static_cast<int>(incomingDirection)][choppedDistance] = result;
-	return result;
+	return table[distance & (window - 1)][static_cast<int>(incomingDirection)];
 }
 
 //int64_t doTheThing(const std::string& stuff, const Vec2& xy, int distance) {
@@ -191,174 +236,410 @@ int64_t doTheThingBigSlowMap(const std::string& stuff, const Vec2& xy, int64_t d
 	return validLandingPointsForSubgrid(bigGrid, Vec2{ gridWidth(bigGrid)/2, gridHeight(bigGrid)/2 }, distance);
 }
 
-int64_t doTheThing(const std::string& stuff, const Vec2& xy, int distance) {
-	return doTheThingBigSlowMap(stuff, xy, distance);
+// The same walk, bit-parallel. Where you could be after s steps is a bitset, one bit per plot and 64 to
+// a word, and taking a step is (left | right | up | down) & ~rocks a whole word at a time. Plots repeat
+// with the garden tiled out in every direction, around the start as far as maxSteps can reach.
+// Counting bits after every step gives the lot:
+// series[s] is how many plots you could be on after exactly s steps, for every s up to maxSteps.
+std::vector<int64_t> reachableSeries(const std::string_view stuff, const Vec2& xy, const int64_t maxSteps) {
+	cauto grid = parseGrid<char>(stuff);
+	assert(grid[xy.y][xy.x] == 'S');
+	cauto side = 2 * maxSteps + 1;
+	cauto rowWords = (side + 63) / 64;
+	cauto wrap = [](const int64_t a, const int64_t m) { return ((a % m) + m) % m; };
+
+	std::vector<uint64_t> open(side * rowWords, 0);
+	for (int64_t y = 0; y < side; y++) {
+		cauto row = grid[wrap(xy.y - maxSteps + y, gridHeight(grid))];
+		for (int64_t x = 0; x < side; x++) {
+			if (row[wrap(xy.x - maxSteps + x, gridWidth(grid))] != '#') {
+				open[y * rowWords + x / 64] |= uint64_t(1) << (x % 64);
+			}
+		}
+	}
+
+	// Once a word's neighbourhood settles it just flips between the same two values every step (you
+	// can always step back where you were), so a word only needs working out if it or a word next to
+	// it changed since two steps ago - that's the edge of the diamond, not the whole of it. Which words
+	// changed is itself a bitset per row. next holds the state from two steps back when it's written
+	// over, which is exactly what to compare against.
+	cauto maskWords = (rowWords + 63) / 64;
+	cauto lastMask = (rowWords % 64 == 0) ? ~uint64_t(0) : (uint64_t(1) << (rowWords % 64)) - 1;
+	std::vector<uint64_t> current(side * rowWords, 0);
+	std::vector<uint64_t> next(side * rowWords, 0);
+	std::vector<uint64_t> changed(side * maskWords, 0);
+	std::vector<uint64_t> nowChanged(side * maskWords, 0);
+	current[maxSteps * rowWords + maxSteps / 64] = uint64_t(1) << (maxSteps % 64);
+	changed[maxSteps * maskWords + maxSteps / 64 / 64] = uint64_t(1) << (maxSteps / 64 % 64);
+	std::vector<int64_t> series{ 1 };
+	for (int64_t step = 1; step <= maxSteps; step++) {
+		int64_t count = (step >= 2) ? series[step - 2] : 0;
+		for (int64_t y = maxSteps - step; y <= maxSteps + step; y++) {
+			cauto row = &changed[y * maskWords];
+			for (int64_t k = 0; k < maskWords; k++) {
+				uint64_t look = row[k] | (row[k] << 1) | (row[k] >> 1);
+				if (k > 0) {
+					look |= row[k - 1] >> 63;
+				}
+				if (k < maskWords - 1) {
+					look |= row[k + 1] << 63;
+				}
+				if (y > 0) {
+					look |= row[k - maskWords];
+				}
+				if (y < side - 1) {
+					look |= row[k + maskWords];
+				}
+				if (k == maskWords - 1) {
+					look &= lastMask;
+				}
+				uint64_t changes = 0;
+				for (; look != 0; look &= look - 1) {
+					cauto bit = std::countr_zero(look);
+					cauto i = k * 64 + bit;
+					cauto index = y * rowWords + i;
+					uint64_t word = (current[index] << 1) | (current[index] >> 1);
+					if (i > 0) {
+						word |= current[index - 1] >> 63;
+					}
+					if (i < rowWords - 1) {
+						word |= current[index + 1] << 63;
+					}
+					if (y > 0) {
+						word |= current[index - rowWords];
+					}
+					if (y < side - 1) {
+						word |= current[index + rowWords];
+					}
+					word &= open[index];
+					if (word != next[index]) {
+						count += std::popcount(word) - std::popcount(next[index]);
+						next[index] = word;
+						changes |= uint64_t(1) << bit;
+					}
+				}
+				nowChanged[y * maskWords + k] = changes;
+			}
+		}
+		series.push_back(count);
+		std::swap(current, next);
+		std::swap(changed, nowChanged);
+	}
+	return series;
 }
-struct CondensedMap {
-	std::array<int64_t, static_cast<int>(CompassDir::Back) + 1> dists;
-	bool visited=false;
-	int totalValidSpots = -1;
-};
 
-using OverMap = Grid<CondensedMap>;
+int64_t doTheThing(const std::string& stuff, const Vec2& xy, int distance) {
+	return reachableSeries(stuff, xy, distance)[distance];
+}
 
-int64_t mapGetDist(const OverMap& overMap, const Vec2& v2, const CompassDir& dir) {
-	return overMap[v2.y][v2.x].dists[static_cast<int>(dir)];
+// the other way to the far away answer: once the walk is past the first tile the count grows
+// quadratically in whole tile widths, so three points of the series (a remainder and one and two
+// widths more) pin it down. Only holds on gardens like the real one, where InfiniteGarden's closed form does
+int64_t doTheThing2QuadraticFit(const std::string& stuff, const Vec2& xy, const int64_t distance) {
+	cauto width = gridWidth(parseGrid<char>(stuff));
+	cauto remainder = distance % width;
+	cauto widths = distance / width;
+	cauto series = reachableSeries(stuff, xy, remainder + 2 * width);
+	cauto y0 = series[remainder];
+	cauto y1 = series[remainder + width];
+	cauto y2 = series[remainder + 2 * width];
+	// Newton's forward differences
+	return y0 + widths * (y1 - y0) + widths * (widths - 1) / 2 * (y2 - 2 * y1 + y0);
 }
+// The garden tiled forever, counted without ever building the big map. Everything comes from
+// distance histograms of the one tile: for each BFS source, how many plots sit at each distance.
+// Plots you can land on after r more steps are the ones at distance <= r with the same parity as r,
+// which is a prefix sum over every other bucket.
+//
+// When the start's row and column and the tile's border are all clear (the real input, not the
+// sample), every tile past the first is entered at one of 8 fixed points, at a distance that only
+// depends on how far out the tile is: a straight line of tiles off each edge and a triangle of
+// them in each quadrant. Tiles far enough in are full and alternate parity, so a whole line or
+// triangle of them is a closed form, and only the last couple of tiles on the edge need the
+// histogram. That's 9 BFSes of one tile for any number of steps.
+//
+// Otherwise it falls back to BFS over tiles: each tile is flood filled from whatever distances its
+// neighbours' edges hand it, and hands its own edges on, until nothing improves. Exact for any
+// garden, but the work grows with the square of the step count.
+class InfiniteGarden {
+public:
+	InfiniteGarden(const std::string_view input, const Vec2& start)
+		: mRocks(parseGrid<bool>(input, [](const char cell) { return cell == '#'; })), mStart(start) {
+		assert(!mRocks[start.y][start.x]);
+		mWidth = gridWidth(mRocks);
+		mHeight = gridHeight(mRocks);
+		if (mWidth == mHeight && clearLines()) {
+			cauto maxX = mWidth - 1;
+			cauto maxY = mHeight - 1;
+			mCentre = distanceHistogram(mRocks, start);
+			// entry point in the tile, and the distance from the start to it
+			cauto entry = [&](const Vec2& at, const int64_t distance) { return Entry{ distanceHistogram(mRocks, at), distance }; };
+			mEdges = {
+				entry({ start.x, maxY }, start.y + 1),           // tiles straight up, come in at the bottom
+				entry({ start.x, 0 }, mHeight - start.y),        // down
+				entry({ maxX, start.y }, start.x + 1),           // left
+				entry({ 0, start.y }, mWidth - start.x),         // right
+			};
+			mCorners = {
+				entry({ maxX, maxY }, start.x + 1 + start.y + 1),
+				entry({ 0, maxY }, mWidth - start.x + start.y + 1),
+				entry({ maxX, 0 }, start.x + 1 + mHeight - start.y),
+				entry({ 0, 0 }, mWidth - start.x + mHeight - start.y),
+			};
+		}
+	}
 
-int64_t doTheThing2(const std::string& stuff, const Vec2& xy, const int64_t distance) {
-	// a flood fill within a flood fill
-	auto grid = parseGrid<char>(stuff);
-	assert(grid[xy.y][xy.x] == 'S');
-	grid[xy.y][xy.x] = '.';
+	// closed form if the tiling allows it, BFS over tiles if not
+	int64_t reachable(const int64_t steps) const {
+		return closedFormApplies() ? reachableClosedForm(steps) : reachableByTiles(steps);
+	}
 
-	// using "OVerMap" here 
-	std::vector<CondensedMap> memoArray(8);
-
-	// will recursion be fast enough, if we memoize? It'll go ~200k calls deep...
-	// let's try it
-	// nope
-	//int64_t sum = validLandingPointsForSubgrid(grid, xy, distance);
-
-	//for(cauto direction: enum_range<CompassDirection>(CompassDirection::Front, CompassDirection::Back)) {
-	//	assert(gridWidth(grid) == gridHeight(grid));
-	//	assert(gridWidth(grid) % 2 == 1);
-	//	cauto distanceTravelledSoFar =
-	//		isCardinal(direction) ? gridWidth(grid) / 2 : manhattanDistance(xy, Vec2(0, 0));
-	//	sum += validLandingPointsForSubgrids(memoArray, grid, direction, distance-distanceTravelledSoFar);
-	//}
-
-	// idea 2, floodfill of floodfills
-	int64_t overMapMaxWidth = 2 * distance / gridWidth(grid) + 1;
-	int64_t overMapMaxHeight = 2 * distance / gridHeight(grid) + 1;
-	OverMap overMap(overMapMaxHeight);
-	for (auto& row : overMap) {
-		row = std::vector<CondensedMap>(overMapMaxWidth, { 0 });
+	bool closedFormApplies() const { return !mCentre.cumulative.empty(); }
+
+	int64_t reachableClosedForm(const int64_t steps) const {
+		assert(closedFormApplies());
+		int64_t sum = mCentre.landing(steps);
+		for (cauto& edge : mEdges) {
+			sum += lineOfTiles(edge, steps);
+		}
+		for (cauto& corner : mCorners) {
+			sum += triangleOfTiles(corner, steps);
+		}
+		return sum;
 	}
 
-	// overmap, innermap
-	// go out in a spiral
-	Vec2 subGridCursor = xy;
-	const Vec2 overMapStart = Vec2(overMapMaxWidth / 2, overMapMaxHeight / 2);
+	int64_t reachableByTiles(const int64_t steps) const;
 
-	Vec2 overMapCursor = Vec2(overMapMaxWidth / 2, overMapMaxHeight / 2);
-	cauto mid = gridWidth(grid) / 2;
-	cauto max = gridWidth(grid) - 1;
+private:
+	struct Entry {
+		DistanceHistogram histogram;
+		int64_t distance;
+	};
 
-	CompassDir travelDir = CompassDir::N;
-	int emptyCells = 0;
-	int64_t sum = 0;
-	for (;;) {
-		// calculate starting point from position relative to start
-		Vec2 thisXY;
-		CompassDir heading;
-		int64_t remainingDistance;
-		if (overMapCursor.x < overMapStart.x) {
-			if (overMapCursor.y < overMapStart.y) {
-				thisXY = Vec2(max, max);
-				heading = CompassDir::NW;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{1, 1}, heading);
-			}
-			else if (overMapCursor.y > overMapStart.y) {
-				thisXY = Vec2(max, 0);
-				heading = CompassDir::W;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{ 1, 0 }, heading);
-			}
-			else {
-				thisXY = Vec2(max, mid);
-				heading = CompassDir::SW;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{ 1, -1 }, heading);
+	bool clearLines() const {
+		for (int64_t i = 0; i < mWidth; i++) {
+			if (mRocks[0][i] || mRocks[mHeight - 1][i] || mRocks[mStart.y][i]) {
+				return false;
 			}
 		}
-		else if (overMapCursor.x > overMapStart.x) {
-			if (overMapCursor.y < overMapStart.y) {
-				thisXY = Vec2(0, max);
-				heading = CompassDir::NE;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{ -1, 1 }, heading);
-			}
-			else if (overMapCursor.y > overMapStart.y) {
-				thisXY = Vec2(0, 0);
-				heading = CompassDir::E;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{ -1, 0 }, heading);
-			}
-			else {
-				thisXY = Vec2(0, mid);
-				heading = CompassDir::SE;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{ -1, -1 }, heading);
+		for (int64_t i = 0; i < mHeight; i++) {
+			if (mRocks[i][0] || mRocks[i][mWidth - 1] || mRocks[i][mStart.x]) {
+				return false;
 			}
 		}
-		else /*if (overMapCursor.x == overMapStart.x)*/ {
-			if (overMapCursor.y < overMapStart.y) {
-				thisXY = Vec2(mid, max);
-				heading = CompassDir::N;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{ 0, 1 }, heading);
-			}
-			else if (overMapCursor.y > overMapStart.y) {
-				thisXY = Vec2(mid, 0);
-				heading = CompassDir::S;
-				remainingDistance = mapGetDist(overMap, overMapCursor + Vec2{ 0, -1 }, heading);
-			}
-			else {
-				thisXY = Vec2(mid, mid);
-				remainingDistance = distance;
-			}
+		return true;
+	}
+
+	// tiles 1, 2, 3... straight out from one edge, entered at entry.distance + (i - 1) * width
+	int64_t lineOfTiles(const Entry& entry, const int64_t steps) const {
+		cauto first = steps - entry.distance;
+		if (first < 0) {
+			return 0;
 		}
-		if (remainingDistance <= 0) {
-			// how do we know when we're done, anyway
-			emptyCells++;
+		cauto count = first / mWidth + 1;
+		cauto full = (first >= entry.histogram.maxDistance()) ? std::min(count, (first - entry.histogram.maxDistance()) / mWidth + 1) : 0;
+		int64_t sum = 0;
+		if (full > 0) {
+			cauto sameParity = (mWidth % 2 == 0) ? full : (full + 1) / 2;
+			sum += sameParity * entry.histogram.landing(first + 2 * entry.histogram.maxDistance());
+			sum += (full - sameParity) * entry.histogram.landing(first + 2 * entry.histogram.maxDistance() + 1);
 		}
-		else {
-
-			cauto choppedDistance = std::min(maxDistance - 1, remainingDistance);
+		for (int64_t i = full; i < count; i++) {
+			sum += entry.histogram.landing(first - i * mWidth);
+		}
+		return sum;
+	}
 
-			CondensedMap overMapEntry;
-			if((remainingDistance==maxDistance-1)&& (memoArray[static_cast<int>(heading)].visited)) {
-				overMapEntry = memoArray[static_cast<int>(heading)];
+	// the quadrant's tiles k steps of a tile out along the diagonal (k + 1 of them) are all entered
+	// at entry.distance + k * width
+	int64_t triangleOfTiles(const Entry& entry, const int64_t steps) const {
+		cauto first = steps - entry.distance;
+		if (first < 0) {
+			return 0;
+		}
+		cauto count = first / mWidth + 1;
+		cauto full = (first >= entry.histogram.maxDistance()) ? std::min(count, (first - entry.histogram.maxDistance()) / mWidth + 1) : 0;
+		int64_t sum = 0;
+		if (full > 0) {
+			cauto sameParityLanding = entry.histogram.landing(first + 2 * entry.histogram.maxDistance());
+			cauto otherParityLanding = entry.histogram.landing(first + 2 * entry.histogram.maxDistance() + 1);
+			if (mWidth % 2 == 0) {
+				sum += sameParityLanding * (full * (full + 1) / 2);
 			}
 			else {
-				auto map = floodFillSubGrid(grid, thisXY, remainingDistance);
-
-				assert(gridWidth(grid) == gridHeight(grid));
+				// k even: 1 + 3 + 5... = evens^2, k odd: 2 + 4 + 6... = odds * (odds + 1)
+				cauto evens = (full + 1) / 2;
+				cauto odds = full / 2;
+				sum += sameParityLanding * evens * evens + otherParityLanding * odds * (odds + 1);
+			}
+		}
+		for (int64_t k = full; k < count; k++) {
+			sum += (k + 1) * entry.histogram.landing(first - k * mWidth);
+		}
+		return sum;
+	}
 
+	Grid<bool> mRocks;
+	Vec2 mStart;
+	int64_t mWidth = 0;
+	int64_t mHeight = 0;
+	DistanceHistogram mCentre;  // empty when the closed form doesn't apply
+	std::array<Entry, 4> mEdges;
+	std::array<Entry, 4> mCorners;
+};
 
-				overMapEntry.dists[(int)CompassDir::NW] = map[0][0];
-				overMapEntry.dists[(int)CompassDir::N] = map[mid][0];
-				overMapEntry.dists[(int)CompassDir::NE] = map[max][0];
-				overMapEntry.dists[(int)CompassDir::E] = map[max][mid];
-				overMapEntry.dists[(int)CompassDir::SE] = map[max][max];
-				overMapEntry.dists[(int)CompassDir::S] = map[mid][max];
-				overMapEntry.dists[(int)CompassDir::SW] = map[0][max];
-				overMapEntry.dists[(int)CompassDir::W] = map[0][mid];
+// Tile-level BFS. A tile only keeps its edges between visits (top, bottom, left, right rows of
+// distances); a visit seeds its cells from the neighbours' facing edges + 1, floods, and passes
+// on any edge that got shorter. Tiles go in order of their nearest seed so most are only done once.
+int64_t InfiniteGarden::reachableByTiles(const int64_t steps) const {
+	constexpr int64_t unreached = std::numeric_limits<int64_t>::max();
+	struct Tile {
+		std::array<std::vector<int64_t>, 4> edges;  // top, bottom, left, right
+		int64_t landing = 0;
+		bool queued = false;  // edges next to it changed since it was last flooded
+	};
+	std::map<Vec2, Tile> tiles;
+	using Queued = std::pair<int64_t, Vec2>;
+	cauto later = [](const Queued& a, const Queued& b) { return a.first > b.first; };
+	std::priority_queue<Queued, std::vector<Queued>, decltype(later)> queue(later);
+	queue.push({ 0, Vec2{ 0, 0 } });
+	tiles[Vec2{ 0, 0 }].queued = true;
+
+	auto distances = createGrid<int64_t>(mWidth, mHeight, unreached);
+	std::vector<std::pair<int64_t, Vec2>> seeds;
+	std::vector<Vec2> frontier;
+	std::vector<Vec2> next;
+	for (; !queue.empty();) {
+		cauto at = queue.top().second;
+		queue.pop();
+		if (!std::exchange(tiles[at].queued, false)) {
+			continue;  // already flooded with everything this push knew about
+		}
 
-				overMapEntry.visited = true;
-				overMapEntry.totalValidSpots = countLandingPoints(map, distance % 2);
-				if (remainingDistance == maxDistance - 1) {
-					memoArray[(int)heading] = overMapEntry;
+		// seeds from the four neighbours (and the start, for the first tile)
+		seeds.clear();
+		if (at.x == 0 && at.y == 0) {
+			seeds.push_back({ 0, mStart });
+		}
+		cauto seedEdge = [&](const Vec2& neighbour, const int facingEdge, const bool horizontal, const int64_t fixed) {
+			cauto found = tiles.find(neighbour);
+			if (found == tiles.end() || found->second.edges[facingEdge].empty()) {
+				return;
+			}
+			cauto& edge = found->second.edges[facingEdge];
+			for (int64_t i = 0; i < std::ssize(edge); i++) {
+				if (edge[i] < steps) {
+					seeds.push_back({ edge[i] + 1, horizontal ? Vec2{ i, fixed } : Vec2{ fixed, i } });
 				}
 			}
-			overMap[overMapCursor.y][overMapCursor.x] = overMapEntry;
-			sum += overMapEntry.totalValidSpots;
+		};
+		seedEdge(at + Vec2{ 0, -1 }, 1, true, 0);
+		seedEdge(at + Vec2{ 0, 1 }, 0, true, mHeight - 1);
+		seedEdge(at + Vec2{ -1, 0 }, 3, false, 0);
+		seedEdge(at + Vec2{ 1, 0 }, 2, false, mWidth - 1);
+		std::sort(seeds.begin(), seeds.end(), [](cauto& a, cauto& b) { return a.first < b.first; });
+
+		// flood with the seeds joining in as the frontier reaches their distance
+		for (auto row : distances) {
+			std::fill(row.begin(), row.end(), unreached);
 		}
-		// spiral algorithm; turn right if you can, otherwise go straight
-		cauto clockwiseRotation = (static_cast<int>(travelDir) + 2) % 8;
-		const Vec2 clockwise = compassOffsets[clockwiseRotation];
-		cauto clockwiseStep = overMapCursor + clockwise;
-		if (!overMap[clockwiseStep.y][clockwiseStep.x].visited) {
-			overMapCursor = clockwiseStep;
-			travelDir = static_cast<CompassDir>(clockwiseRotation);
+		int64_t landing = 0;
+		size_t nextSeed = 0;
+		frontier.clear();
+		for (int64_t d = seeds.empty() ? 0 : seeds[0].first; d <= steps && (!frontier.empty() || nextSeed < seeds.size()); d++) {
+			for (; nextSeed < seeds.size() && seeds[nextSeed].first == d; nextSeed++) {
+				cauto& cell = seeds[nextSeed].second;
+				if (!mRocks[cell.y][cell.x] && distances[cell.y][cell.x] == unreached) {
+					distances[cell.y][cell.x] = d;
+					frontier.push_back(cell);
+				}
+			}
+			if ((steps - d) % 2 == 0) {
+				landing += std::ssize(frontier);
+			}
+			next.clear();
+			for (cauto& cell : frontier) {
+				for (cauto& step : { Vec2{ 1, 0 }, Vec2{ -1, 0 }, Vec2{ 0, 1 }, Vec2{ 0, -1 } }) {
+					cauto to = cell + step;
+					if (inBounds(mRocks, to) && !mRocks[to.y][to.x] && distances[to.y][to.x] == unreached) {
+						distances[to.y][to.x] = d + 1;
+						next.push_back(to);
+					}
+				}
+			}
+			std::swap(frontier, next);
+			if (frontier.empty() && nextSeed < seeds.size()) {
+				d = seeds[nextSeed].first - 1;
+			}
+		}
+
+		auto& tile = tiles[at];
+		tile.landing = landing;
+		std::array<std::vector<int64_t>, 4> edges;
+		for (int64_t x = 0; x < mWidth; x++) {
+			edges[0].push_back(distances[0][x]);
+			edges[1].push_back(distances[mHeight - 1][x]);
 		}
-		else {
-			overMapCursor = overMapCursor + compassOffsets[static_cast<int>(travelDir)];
+		for (int64_t y = 0; y < mHeight; y++) {
+			edges[2].push_back(distances[y][0]);
+			edges[3].push_back(distances[y][mWidth - 1]);
+		}
+		static const std::array<Vec2, 4> towards = { Vec2{ 0, -1 }, Vec2{ 0, 1 }, Vec2{ -1, 0 }, Vec2{ 1, 0 } };
+		for (int side = 0; side < 4; side++) {
+			cauto& old = tile.edges[side];
+			bool improved = false;
+			int64_t best = unreached;
+			for (size_t i = 0; i < edges[side].size(); i++) {
+				improved = improved || (old.empty() ? edges[side][i] < unreached : edges[side][i] < old[i]);
+				best = std::min(best, edges[side][i]);
+			}
+			tile.edges[side] = std::move(edges[side]);
+			if (improved && best < steps) {
+				queue.push({ best + 1, at + towards[side] });
+				tiles[at + towards[side]].queued = true;
+			}
 		}
 	}
 
+	int64_t sum = 0;
+	for (cauto& [at, tile] : tiles) {
+		sum += tile.landing;
+	}
 	return sum;
 }
 
+int64_t doTheThing2(const std::string& stuff, const Vec2& xy, const int64_t distance) {
+	return InfiniteGarden(stuff, xy).reachable(distance);
+}
+
 TEST(Aoc21Tests, TestTest) {
     ASSERT_EQ(1,1);
 }
 
+TEST(Aoc21Tests, createGrid_rowsShareOnePaddedAllocation) {
+	auto grid = createGrid<char>(3, 2, '.');
+	ASSERT_EQ(3, gridWidth(grid));
+	ASSERT_EQ(2, gridHeight(grid));
+	ASSERT_EQ(0, grid.stride() % Grid<char>::cacheLineBytes);
+	ASSERT_EQ(grid.data() + grid.stride(), grid[1].data());
+	grid[1][2] = '#';
+	ASSERT_EQ('#', grid.data()[grid.stride() + 2]);
+}
+
+TEST(Aoc21Tests, parseGrid_transformAndCompare) {
+	cauto grid = parseGrid<char>("#.\n.#\n..");
+	cauto distances = gridTransform<int16_t>(grid, [](cauto cell) { return static_cast<int16_t>(cell == '#' ? -2 : -1); });
+	ASSERT_EQ((Grid<int16_t>{ {-2, -1}, {-1, -2}, {-1, -1} }), distances);
+	ASSERT_TRUE(inBounds(distances, Vec2{ 1, 2 }));
+	ASSERT_FALSE(inBounds(distances, Vec2{ 2, 1 }));
+}
+
+TEST(Aoc21Tests, parseGrid_raggedRowsArePadded) {
+	ASSERT_FALSE(gridView("#..\r\n.#\r\n#"));
+	cauto grid = parseGrid<char>("#..\r\n.#\r\n#");
+	ASSERT_EQ((Grid<char>{ { '#', '.', '.' }, { '.', '#', '\0' }, { '#', '\0', '\0' } }), grid);
+}
+
 
 
 const std::string sampleInput = 
@@ -559,24 +840,117 @@ TEST(Aoc21Tests, garden_doTheThing) {
 // 26501365 has that telling "65" at the end.
 // 26501300/131 is 202300 - so we go 65 steps and then 202300 map heights/widths.
 TEST(Aoc21Tests, garden_2widths_doTheThing) {
-	ASSERT_EQ(0, doTheThing(garden, { 65, 65 }, 131*2+65));
+	ASSERT_EQ(95798, doTheThing(garden, { 65, 65 }, 131*2+65));
 }
 
 TEST(Aoc21Tests, garden_4widths_doTheThing) {
-	ASSERT_EQ(0, doTheThing(garden, { 65, 65 }, 131 * 4 +65));
+	ASSERT_EQ(310018, doTheThing(garden, { 65, 65 }, 131 * 4 +65));
 }
 
 TEST(Aoc21Tests, garden_8widths_doTheThing) {
-	ASSERT_EQ(0, doTheThing(garden, { 65, 65 }, 131 * 8 +65));
+	ASSERT_EQ(1105346, doTheThing(garden, { 65, 65 }, 131 * 8 +65));
 }
 
 TEST(Aoc21Tests, garden_16widths_doTheThing) {
-	ASSERT_EQ(0, doTheThing(garden, { 65, 65 }, 131 * 16 +65));
+	ASSERT_EQ(4163554, doTheThing(garden, { 65, 65 }, 131 * 16 +65));
 }
 
 TEST(Aoc21Tests, garden_32widths_doTheThing) {
 
-	ASSERT_EQ(0, doTheThing(garden, { 65, 65 }, 131 * 32+65));
+	ASSERT_EQ(16150178, doTheThing(garden, { 65, 65 }, 131 * 32+65));
+}
+
+TEST(Aoc21Tests, sampleInput_doTheThing2_matchesBigMap) {
+	// the sample's middle row and column have rocks in, so this is the tile by tile BFS
+	ASSERT_FALSE(InfiniteGarden(sampleInput, { 5, 5 }).closedFormApplies());
+	for (cauto steps : { 0, 1, 6, 10, 11, 12, 50, 100, 500, 1000 }) {
+		ASSERT_EQ(doTheThing(sampleInput, { 5, 5 }, steps), doTheThing2(sampleInput, { 5, 5 }, steps));
+	}
+}
+
+TEST(Aoc21Tests, garden_doTheThing2_matchesBigMap) {
+	cauto infinite = InfiniteGarden(garden, { 65, 65 });
+	ASSERT_TRUE(infinite.closedFormApplies());
+	// including step counts that end part way into a tile, and ones short of the first edge
+	for (cauto steps : { 0, 1, 2, 64, 65, 66, 100, 130, 131, 132, 196, 200, 131 * 2 + 65, 500, 131 * 4 + 30 }) {
+		ASSERT_EQ(doTheThing(garden, { 65, 65 }, steps), infinite.reachableClosedForm(steps));
+		ASSERT_EQ(infinite.reachableClosedForm(steps), infinite.reachableByTiles(steps));
+	}
+}
+
+// the old way, a flood fill per call and no memo at all, to check the table against
+int64_t recursiveLandingPoints(const Grid<char>& grid, const CompassDir incomingDirection, const int64_t distance) {
+	if (distance <= 0) {
+		return 0;
+	}
+	cauto w = gridWidth(grid);
+	cauto h = gridHeight(grid);
+	int64_t result = validLandingPointsForSubgrid(grid, subgridEntry(grid, incomingDirection), distance);
+	if (!isCardinal(incomingDirection)) {
+		cauto sideways = (incomingDirection == CompassDir::NW || incomingDirection == CompassDir::SW) ? CompassDir::W : CompassDir::E;
+		cauto onwards = (incomingDirection == CompassDir::NW || incomingDirection == CompassDir::NE) ? CompassDir::N : CompassDir::S;
+		result += recursiveLandingPoints(grid, sideways, distance - w - h / 2);
+		result += recursiveLandingPoints(grid, incomingDirection, distance - w - h - 1);
+		result += recursiveLandingPoints(grid, onwards, distance - w / 2 - h);
+	}
+	else {
+		result += recursiveLandingPoints(grid, incomingDirection, distance - w);
+	}
+	return result;
+}
+
+TEST(Aoc21Tests, distanceHistogram_matchesFloodFill) {
+	for (cauto& input : { sampleInput, garden }) {
+		auto grid = parseGrid<char>(input);
+		cauto rocks = gridTransform<bool>(grid, [](cauto cell) { return cell == '#'; });
+		for (int dir = 0; dir <= static_cast<int>(CompassDir::Back); dir++) {
+			cauto entry = subgridEntry(grid, static_cast<CompassDir>(dir));
+			cauto histogram = distanceHistogram(rocks, entry);
+			for (cauto d : { 0, 1, 2, 5, 10, 11, 30, 130, 131, 260, 261, 400 }) {
+				ASSERT_EQ(validLandingPointsForSubgrid(grid, entry, d), histogram.landing(d));
+			}
+		}
+	}
+}
+
+TEST(Aoc21Tests, validLandingPointsForSubgrids_matchesRecursion) {
+	cauto grid = parseGrid<char>(sampleInput);
+	for (int dir = 0; dir <= static_cast<int>(CompassDir::Back); dir++) {
+		for (int64_t d = -1; d <= 70; d++) {
+			ASSERT_EQ(recursiveLandingPoints(grid, static_cast<CompassDir>(dir), d), validLandingPointsForSubgrids(grid, static_cast<CompassDir>(dir), d));
+		}
+	}
+	cauto big = parseGrid<char>(garden);
+	for (cauto d : { 64, 131, 300, 301, 500 }) {
+		ASSERT_EQ(recursiveLandingPoints(big, CompassDir::NE, d), validLandingPointsForSubgrids(big, CompassDir::NE, d));
+		ASSERT_EQ(recursiveLandingPoints(big, CompassDir::S, d), validLandingPointsForSubgrids(big, CompassDir::S, d));
+	}
+}
+
+TEST(Aoc21Tests, reachableSeries_matchesBigMapEveryStep) {
+	cauto series = reachableSeries(sampleInput, { 5, 5 }, 60);
+	ASSERT_EQ(61, std::ssize(series));
+	for (int64_t steps = 0; steps <= 60; steps++) {
+		ASSERT_EQ(doTheThingBigSlowMap(sampleInput, { 5, 5 }, steps), series[steps]);
+	}
+	cauto gardenSeries = reachableSeries(garden, { 65, 65 }, 200);
+	for (cauto steps : { 0, 1, 64, 65, 131, 200 }) {
+		ASSERT_EQ(doTheThingBigSlowMap(garden, { 65, 65 }, steps), gardenSeries[steps]);
+	}
+}
+
+TEST(Aoc21Tests, garden_doTheThing2QuadraticFit) {
+	ASSERT_EQ(doTheThing2(garden, { 65, 65 }, 131 * 32 + 65), doTheThing2QuadraticFit(garden, { 65, 65 }, 131 * 32 + 65));
+	ASSERT_EQ(625628021226274, doTheThing2QuadraticFit(garden, { 65, 65 }, 26501365));
+}
+
+TEST(Aoc21Tests, garden_32widths_doTheThing2) {
+	ASSERT_EQ(16150178, doTheThing2(garden, { 65, 65 }, 131 * 32 + 65));
+}
+
+TEST(Aoc21Tests, garden_doTheThing2) {
+	// same as the quadratic through the 2, 4 and 8 widths counts above, evaluated at 202300 widths
+	ASSERT_EQ(625628021226274, doTheThing2(garden, { 65, 65 }, 26501365));
 }
 
 // see spread sheet https://1drv.ms/x/s!At-FVBW8gf7IhYcN_PYyfo7YivMv7w?e=4UzrxQ for final calculations
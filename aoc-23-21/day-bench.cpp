@@ -0,0 +1,37 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include <cmath>
+
+#include "aoc-21-test.cpp"
+
+#include "aoc-bench.h"
+
+// the garden tiled k x k with the only S in the middle, for walking k times as far
+std::string bigGarden(const int tiles) {
+	auto result = aoc_bench::tileGrid(garden, tiles, tiles);
+	std::replace(result.begin(), result.end(), 'S', '.');
+	const auto width = static_cast<size_t>(131 * tiles);
+	result[(width / 2) * (width + 1) + width / 2] = 'S';
+	return result;
+}
+
+void aoc_bench::registerDay() {
+	add("day21/doTheThing/sample", [] { return doTheThing(sampleInput, { 5, 5 }, 6); });
+	add("day21/doTheThing/sample_100steps", [] { return doTheThing(sampleInput, { 5, 5 }, 100); });
+	add("day21/doTheThing/puzzle", [] { return doTheThing(garden, { 65, 65 }, 64); });
+	add("day21/doTheThing/puzzle_2widths", [] { return doTheThing(garden, { 65, 65 }, 131 * 2 + 65); });
+	add("day21/doTheThingBigSlowMap/puzzle_2widths", [] { return doTheThingBigSlowMap(garden, { 65, 65 }, 131 * 2 + 65); });
+	add("day21/doTheThing2QuadraticFit/puzzle", [] { return doTheThing2QuadraticFit(garden, { 65, 65 }, 26501365); });
+	add("day21/doTheThing2/puzzle_2widths", [] { return doTheThing2(garden, { 65, 65 }, 131 * 2 + 65); });
+	add("day21/doTheThing2/puzzle", [] { return doTheThing2(garden, { 65, 65 }, 26501365); });
+	add("day21/InfiniteGarden::reachableByTiles/puzzle_2widths", [] { return InfiniteGarden(garden, { 65, 65 }).reachableByTiles(131 * 2 + 65); });
+	add("day21/validLandingPointsForSubgrids/puzzle_500steps", [] { return validLandingPointsForSubgrids(parseGrid<char>(garden), CompassDir::NE, 500); });
+	add("day21/validLandingPointsForSubgrids/puzzle", [] { return validLandingPointsForSubgrids(parseGrid<char>(garden), CompassDir::NE, 26501365); });
+	add("day21/doTheThing2/sample_1000steps", [] { return doTheThing2(sampleInput, { 5, 5 }, 1000); });
+	for (const auto& [scale, suffix] : scales) {
+		const auto tiles = tilesFor(scale);
+		const auto scaled = bigGarden(tiles);
+		const Vec2 middle{ 131 * tiles / 2, 131 * tiles / 2 };
+		add(std::string("day21/doTheThing/") + suffix, [scaled, middle, tiles] { return doTheThing(scaled, middle, 64 * tiles); });
+	}
+}
@@ -0,0 +1,107 @@
+// quick and dirty microbenchmark: the old vector-of-vectors grid against the flat, strided Grid
+// on the two access patterns that were hurting - floodFill's BFS and a vertical neighbour sweep.
+// no gtest here on purpose, build it in Release and just run it.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <queue>
+#include <sstream>
+
+#include "pex.h"
+
+template <typename T>
+using NestedGrid = std::vector<std::vector<T>>;
+
+template <typename GridType>
+void fillRocks(GridType& grid, const int64_t width, const int64_t height) {
+	// cheap LCG so both layouts get the exact same garden
+	uint32_t seed = 12345;
+	for (int64_t y = 0; y < height; y++) {
+		for (int64_t x = 0; x < width; x++) {
+			seed = seed * 1664525u + 1013904223u;
+			grid[y][x] = (seed >> 24) < 26 ? -2 : -1; // ~10% rocks
+		}
+	}
+	grid[height / 2][width / 2] = -1;
+}
+
+// same shape as floodFill in aoc-21-test.cpp, minus the inBounds overload
+template <typename GridType>
+int64_t bfs(GridType& map, const int64_t width, const int64_t height, const Vec2& start) {
+	std::queue<std::pair<Vec2, int64_t>> fillPoints;
+	fillPoints.push({ start, 0 });
+	int64_t filled = 0;
+	for (; !fillPoints.empty();) {
+		cauto[spot, steps] = fillPoints.front();
+		fillPoints.pop();
+		if (spot.x >= 0 && spot.y >= 0 && spot.x < width && spot.y < height && map[spot.y][spot.x] == -1) {
+			map[spot.y][spot.x] = static_cast<int16_t>(steps % 30000);
+			++filled;
+			fillPoints.push({ { spot.x - 1, spot.y }, steps + 1 });
+			fillPoints.push({ { spot.x + 1, spot.y }, steps + 1 });
+			fillPoints.push({ { spot.x, spot.y - 1 }, steps + 1 });
+			fillPoints.push({ { spot.x, spot.y + 1 }, steps + 1 });
+		}
+	}
+	return filled;
+}
+
+// column-major walk, so every step is a vertical neighbour
+template <typename GridType>
+int64_t verticalSweep(const GridType& map, const int64_t width, const int64_t height) {
+	int64_t sum = 0;
+	for (int64_t x = 0; x < width; x++) {
+		for (int64_t y = 1; y < height - 1; y++) {
+			sum += map[y - 1][x] + map[y + 1][x];
+		}
+	}
+	return sum;
+}
+
+template <typename Func>
+double timeIt(const int reps, Func func) {
+	cauto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < reps; i++) {
+		func();
+	}
+	cauto elapsed = std::chrono::steady_clock::now() - start;
+	return std::chrono::duration<double, std::milli>(elapsed).count() / reps;
+}
+
+int main() {
+	constexpr int reps = 5;
+	for (const int64_t size : { 131, 1024, 4096 }) {
+		NestedGrid<int16_t> nested(size, std::vector<int16_t>(size));
+		auto flat = createGrid<int16_t>(size, size);
+		fillRocks(nested, size, size);
+		fillRocks(flat, size, size);
+		cauto nestedPristine = nested;
+		cauto flatPristine = flat;
+		const Vec2 start{ size / 2, size / 2 };
+
+		int64_t nestedFilled = 0;
+		int64_t flatFilled = 0;
+		cauto nestedBfs = timeIt(reps, [&]() { nested = nestedPristine; nestedFilled = bfs(nested, size, size, start); });
+		cauto flatBfs = timeIt(reps, [&]() { flat = flatPristine; flatFilled = bfs(flat, size, size, start); });
+		if (nestedFilled != flatFilled) {
+			std::cerr << size << "x" << size << ": floodFill filled " << nestedFilled << " nested but " << flatFilled << " flat" << std::endl;
+			return 1;
+		}
+
+		int64_t nestedSum = 0;
+		int64_t flatSum = 0;
+		cauto nestedSweep = timeIt(reps, [&]() { nestedSum = verticalSweep(nested, size, size); });
+		cauto flatSweep = timeIt(reps, [&]() { flatSum = verticalSweep(flat, size, size); });
+		if (nestedSum != flatSum) {
+			std::cerr << size << "x" << size << ": verticalSweep summed " << nestedSum << " nested but " << flatSum << " flat" << std::endl;
+			return 1;
+		}
+
+		std::cout << size << "x" << size << " (stride " << flat.stride() << ", " << flatFilled << " filled)" << std::endl;
+		std::cout << "  floodFill      nested " << nestedBfs << " ms  flat " << flatBfs << " ms" << std::endl;
+		std::cout << "  verticalSweep  nested " << nestedSweep << " ms  flat " << flatSweep << " ms" << std::endl;
+	}
+	return 0;
+}
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <format>
 #include <queue>
+#include <stdexcept>
+#include <thread>
 #include <unordered_set>
 #include <string>
 
@@ -15,7 +20,7 @@ const std::vector<Vec2> dirs{ {0,-1}, {1,0}, {0,1}, {-1,0} };  // never eat shre
 
 
 
-using CharGrid = std::vector<std::vector<char>>;
+using CharGrid = Grid<char>;
 
 struct Node {
     std::vector<std::pair<Vec2,int64_t>> edges;
@@ -154,6 +159,280 @@ int64_t maximumPathFromGraph(
     return highest;
 }
 
+// The trail contracted down to its junctions, plus the start and the exit, in compressed sparse row
+// form: junction j's edges are edges[offsets[j]] up to edges[offsets[j + 1]]. The start is always 0
+// and the exit is always 1, the rest are numbered in reading order.
+struct JunctionCsr {
+    static constexpr int32_t start = 0;
+    static constexpr int32_t exit = 1;
+
+    struct Edge {
+        int32_t to;
+        int32_t cost;
+    };
+    std::vector<int32_t> offsets;
+    std::vector<Edge> edges;
+
+    int32_t nodeCount() const { return static_cast<int32_t>(offsets.size()) - 1; }
+};
+
+// nodify and doublyLink's job without the recursion or the hash map. A junction is any open cell
+// with three or more ways out, and they're all found up front with one scan of the grid into a flat
+// cell -> junction index table. Then each corridor gets walked once, from whichever end gets to it
+// first, and cells are marked as it goes so the far end knows not to bother. One walk is enough for
+// both directions: going forwards every slope has to point the way we're going, and coming back every
+// slope has to point the way we'd leave it in reverse. Two corridors between the same junctions end up
+// as one edge, the longer one. Corridors that dead end, or come back to where they started, go nowhere
+// a hike would want to, so they're dropped.
+JunctionCsr buildJunctionCsr(const CharGrid& grid, const bool slipperySlopes) {
+    cauto width = gridWidth(grid);
+    cauto height = gridHeight(grid);
+    cauto cellIndex = [width](const Vec2& xy) { return xy.y * width + xy.x; };
+    cauto open = [&grid](const Vec2& xy) { return inBounds(grid, xy) && grid[xy.y][xy.x] != '#'; };
+    cauto canStep = [&grid, slipperySlopes](const Vec2& onto, const Vec2& dir) {
+        return !slipperySlopes || rightWay(grid[onto.y][onto.x], dir);
+    };
+
+    const Vec2 start{ 1, 0 };
+    const Vec2 exit{ width - 2, height - 1 };
+    std::vector<int32_t> junctionAt(width * height, -1);
+    std::vector<Vec2> junctions{ start, exit };
+    junctionAt[cellIndex(start)] = JunctionCsr::start;
+    junctionAt[cellIndex(exit)] = JunctionCsr::exit;
+    for (int64_t y = 0; y < height; y++) {
+        for (int64_t x = 0; x < width; x++) {
+            const Vec2 xy{ x, y };
+            if (!open(xy) || junctionAt[cellIndex(xy)] != -1) {
+                continue;
+            }
+            cauto waysOut = std::count_if(dirs.begin(), dirs.end(), [&](cauto& dir) { return open(xy + dir); });
+            if (waysOut >= 3) {
+                junctionAt[cellIndex(xy)] = static_cast<int32_t>(junctions.size());
+                junctions.push_back(xy);
+            }
+        }
+    }
+
+    struct Link {
+        int32_t from;
+        JunctionCsr::Edge edge;
+    };
+    std::vector<Link> links;
+    std::vector<bool> walked(width * height, false);
+    for (int32_t from = 0; from < std::ssize(junctions); from++) {
+        for (int firstDir = 0; firstDir < 4; firstDir++) {
+            Vec2 cell = junctions[from] + dirs[firstDir];
+            if (!open(cell) || walked[cellIndex(cell)]) {
+                continue;
+            }
+            int dir = firstDir;
+            bool forwards = canStep(cell, dirs[dir]);
+            bool backwards = canStep(junctions[from], -dirs[dir]);
+            int32_t cost = 1;
+            bool deadEnd = false;
+            while (junctionAt[cellIndex(cell)] == -1) {
+                walked[cellIndex(cell)] = true;
+                // not a junction, so there's at most one way on that isn't straight back
+                int nextDir = -1;
+                for (int turn : { 0, 1, 3 }) {
+                    if (open(cell + dirs[(dir + turn) % 4])) {
+                        nextDir = (dir + turn) % 4;
+                    }
+                }
+                if (nextDir == -1) {
+                    deadEnd = true;
+                    break;
+                }
+                backwards = backwards && canStep(cell, -dirs[nextDir]);
+                dir = nextDir;
+                cell = cell + dirs[dir];
+                forwards = forwards && canStep(cell, dirs[dir]);
+                cost++;
+            }
+            cauto to = deadEnd ? -1 : junctionAt[cellIndex(cell)];
+            // a junction right next to another has no corridor cells to mark, so it'd come up from both ends
+            if (to == -1 || to == from || (cost == 1 && to < from)) {
+                continue;
+            }
+            if (forwards) {
+                links.push_back({ from, { to, cost } });
+            }
+            if (backwards) {
+                links.push_back({ to, { from, cost } });
+            }
+        }
+    }
+
+    // counting sort by where the edge starts, and the longest of any parallel corridors wins
+    JunctionCsr csr;
+    csr.offsets.assign(junctions.size() + 1, 0);
+    for (cauto& link : links) {
+        csr.offsets[link.from + 1]++;
+    }
+    std::partial_sum(csr.offsets.begin(), csr.offsets.end(), csr.offsets.begin());
+    std::vector<JunctionCsr::Edge> sorted(links.size());
+    auto fill = csr.offsets;
+    for (cauto& link : links) {
+        sorted[fill[link.from]++] = link.edge;
+    }
+    csr.edges.reserve(sorted.size());
+    for (int32_t node = 0; node < std::ssize(junctions); node++) {
+        cauto first = std::ssize(csr.edges);
+        for (int32_t i = csr.offsets[node]; i < csr.offsets[node + 1]; i++) {
+            cauto same = std::find_if(csr.edges.begin() + first, csr.edges.end(), [&](cauto& edge) { return edge.to == sorted[i].to; });
+            if (same == csr.edges.end()) {
+                csr.edges.push_back(sorted[i]);
+            }
+            else {
+                same->cost = std::max(same->cost, sorted[i].cost);
+            }
+        }
+        csr.offsets[node] = static_cast<int32_t>(first);
+    }
+    csr.offsets.back() = static_cast<int32_t>(csr.edges.size());
+    return csr;
+}
+
+// The junctions again, small enough now that a path's visited set is a single uint64_t and walking
+// an edge doesn't hash anything.
+struct JunctionGraph {
+    static constexpr int maxNodes = 64;
+    static constexpr int maxDegree = 4;
+    static constexpr int start = JunctionCsr::start;
+    static constexpr int exit = JunctionCsr::exit;
+
+    int nodeCount = 0;
+    std::array<int, maxNodes> degree{};
+    std::array<std::array<int, maxDegree>, maxNodes> neighbours{};
+    std::array<std::array<int64_t, maxDegree>, maxNodes> costs{};
+    std::array<uint64_t, maxNodes> neighbourMask{};
+    std::array<int64_t, maxNodes> longestEdgeIn{};  // the most a path can pick up by stepping onto a junction
+};
+
+// Mazes with more junctions than that, or a junction with more ways out, don't fit and get rejected -
+// even in Release, where the shift and the arrays would otherwise quietly go past the end.
+JunctionGraph compressGraph(const JunctionCsr& csr) {
+    if (csr.nodeCount() > JunctionGraph::maxNodes) {
+        throw std::invalid_argument(std::to_string(csr.nodeCount()) + " junctions, a JunctionGraph holds at most " + std::to_string(JunctionGraph::maxNodes));
+    }
+    JunctionGraph junctions;
+    junctions.nodeCount = csr.nodeCount();
+    for (int from = 0; from < junctions.nodeCount; from++) {
+        for (int32_t i = csr.offsets[from]; i < csr.offsets[from + 1]; i++) {
+            cauto& edge = csr.edges[i];
+            auto& degree = junctions.degree[from];
+            if (degree >= JunctionGraph::maxDegree) {
+                throw std::invalid_argument("junction " + std::to_string(from) + " has more than " + std::to_string(JunctionGraph::maxDegree) + " edges");
+            }
+            junctions.neighbours[from][degree] = edge.to;
+            junctions.costs[from][degree] = edge.cost;
+            junctions.neighbourMask[from] |= uint64_t(1) << edge.to;
+            junctions.longestEdgeIn[edge.to] = std::max(junctions.longestEdgeIn[edge.to], int64_t(edge.cost));
+            degree++;
+        }
+    }
+    return junctions;
+}
+
+// everything a flood from `from` can get to without stepping on anything in visited
+uint64_t reachableJunctions(const JunctionGraph& junctions, const int from, const uint64_t visited) {
+    uint64_t seen = uint64_t(1) << from;
+    for (uint64_t frontier = seen; frontier;) {
+        uint64_t next = 0;
+        for (uint64_t bits = frontier; bits; bits &= bits - 1) {
+            next |= junctions.neighbourMask[std::countr_zero(bits)];
+        }
+        frontier = next & ~seen & ~visited;
+        seen |= frontier;
+    }
+    return seen;
+}
+
+// Plain DFS, but before going any deeper it floods out from here: if the exit's been cut off there's
+// nothing to find, and even if every junction still reachable got added to the path via its longest
+// edge in, that has to beat the best so far or there's no point looking. best can be shared between
+// threads, so any thread's find prunes everyone else's search too.
+void longestHikeFrom(const JunctionGraph& junctions, const int node, const uint64_t visited, const int64_t cost, std::atomic<int64_t>& best) {
+    if (node == JunctionGraph::exit) {
+        for (auto seen = best.load(std::memory_order_relaxed); cost > seen && !best.compare_exchange_weak(seen, cost, std::memory_order_relaxed);) {}
+        return;
+    }
+    cauto reachable = reachableJunctions(junctions, node, visited);
+    if (!(reachable & (uint64_t(1) << JunctionGraph::exit))) {
+        return;
+    }
+    int64_t bound = cost;
+    for (uint64_t bits = reachable & ~visited; bits; bits &= bits - 1) {
+        bound += junctions.longestEdgeIn[std::countr_zero(bits)];
+    }
+    if (bound <= best.load(std::memory_order_relaxed)) {
+        return;
+    }
+    for (int i = 0; i < junctions.degree[node]; i++) {
+        cauto next = junctions.neighbours[node][i];
+        cauto nextBit = uint64_t(1) << next;
+        if (!(visited & nextBit)) {
+            longestHikeFrom(junctions, next, visited | nextBit, cost + junctions.costs[node][i], best);
+        }
+    }
+}
+
+// somewhere partway down the search tree, everything needed to carry on from there
+struct HikePrefix {
+    int node;
+    uint64_t visited;
+    int64_t cost;
+};
+
+// every path from the start that's depth junctions long (or that got to the exit sooner)
+std::vector<HikePrefix> hikePrefixes(const JunctionGraph& junctions, const int depth) {
+    std::vector<HikePrefix> prefixes{ { JunctionGraph::start, uint64_t(1) << JunctionGraph::start, 0 } };
+    for (int level = 0; level < depth; level++) {
+        std::vector<HikePrefix> deeper;
+        for (cauto& prefix : prefixes) {
+            if (prefix.node == JunctionGraph::exit) {
+                deeper.push_back(prefix);
+                continue;
+            }
+            for (int i = 0; i < junctions.degree[prefix.node]; i++) {
+                cauto next = junctions.neighbours[prefix.node][i];
+                cauto nextBit = uint64_t(1) << next;
+                if (!(prefix.visited & nextBit)) {
+                    deeper.push_back({ next, prefix.visited | nextBit, prefix.cost + junctions.costs[prefix.node][i] });
+                }
+            }
+        }
+        prefixes = std::move(deeper);
+    }
+    return prefixes;
+}
+
+// The tree gets cut off hikePrefixDepth junctions down and the prefixes handed out one at a time off a
+// shared counter, since some are dead ends the bound kills straight away and some are most of the work.
+// A threads of 1 is the plain single-threaded search.
+constexpr int hikePrefixDepth = 8;
+
+int64_t longestHike(const JunctionGraph& junctions, const unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+    std::atomic<int64_t> best = -1;  // stays -1 if there's no way out at all
+    if (threads <= 1) {
+        longestHikeFrom(junctions, JunctionGraph::start, uint64_t(1) << JunctionGraph::start, 0, best);
+        return best;
+    }
+    cauto prefixes = hikePrefixes(junctions, hikePrefixDepth);
+    std::atomic<int64_t> nextPrefix = 0;
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&]() {
+                for (auto i = nextPrefix++; i < std::ssize(prefixes); i = nextPrefix++) {
+                    longestHikeFrom(junctions, prefixes[i].node, prefixes[i].visited, prefixes[i].cost, best);
+                }
+            });
+        }
+    }
+    return best;
+}
+
 
 
 int64_t processNextStep(
@@ -232,14 +511,9 @@ int64_t processNextStep(
 }
 
 
-int64_t doTheThing(const std::string& input, const bool slipperySlopes) {
-    cauto charGrid = parseGrid<char>(input);
-    auto visited = createGrid<bool>(gridWidth(charGrid), gridHeight(charGrid));
-    return maximumPath(charGrid, visited, { 1,0 }, { gridWidth(charGrid)-2, gridHeight(charGrid)-1 }, slipperySlopes, 0ll);
-}
-
-int64_t doTheThing2(const std::string& input, const bool slipperySlopes) {
-    cauto rawGrid = parseGrid<char>(input);
+// nodify and doublyLink's graph of the trail's junctions, slopes flattened first if they're not slippery.
+// buildJunctionCsr does this now, this is kept to check it against
+Graph junctionGraph(const CharGrid& rawGrid, const bool slipperySlopes) {
     cauto charGrid = slipperySlopes ? rawGrid :
         gridTransform<char>(rawGrid, [](cauto cell) { 
             return ("^>v<"s.find(cell) != std::string::npos) ? '.' : cell; 
@@ -250,12 +524,18 @@ int64_t doTheThing2(const std::string& input, const bool slipperySlopes) {
     auto coverage = charGrid;
     nodify(graph, coverage, charGrid, { 1,0 }, { 1,1 }, { gridWidth(charGrid) - 2, gridHeight(charGrid) - 1 });
     //std::cout << coverage << std::endl;
-    std::cout << graph << std::endl;
-    auto dGraph = slipperySlopes ? graph : doublyLink(graph);
-    std::cout << dGraph << std::endl;
+    return slipperySlopes ? graph : doublyLink(graph);
+}
 
-    Visited visited;
-    return maximumPathFromGraph(dGraph, visited, { 1,0 }, { gridWidth(charGrid) - 2, gridHeight(charGrid) - 1 }, 0);
+int64_t doTheThing(const std::string& input, const bool slipperySlopes) {
+    return longestHike(compressGraph(buildJunctionCsr(parseGrid<char>(input), slipperySlopes)), 1);
+}
+
+// both parts used to be their own search - the cell by cell maximumPath and maximumPathFromGraph's
+// walk over the unordered_map - now they're both longestHike and the old ones are only checked against.
+// This one's the one that gets to use every core.
+int64_t doTheThing2(const std::string& input, const bool slipperySlopes, const unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+    return longestHike(compressGraph(buildJunctionCsr(parseGrid<char>(input), slipperySlopes)), threads);
 }
 
 const std::string sampleInput = 
@@ -293,6 +573,74 @@ TEST(Aoc23Tests, sampleInputNotSlippery_doTheThing2_154) {
     ASSERT_EQ(154, doTheThing2(sampleInput, false));
 }
 
+int64_t cellByCell(const std::string& input, const bool slipperySlopes) {
+    cauto charGrid = parseGrid<char>(input);
+    auto visited = createGrid<bool>(gridWidth(charGrid), gridHeight(charGrid));
+    return maximumPath(charGrid, visited, { 1,0 }, { gridWidth(charGrid) - 2, gridHeight(charGrid) - 1 }, slipperySlopes, 0ll);
+}
+
+int64_t unorderedMapWalk(const std::string& input, const bool slipperySlopes) {
+    cauto charGrid = parseGrid<char>(input);
+    auto graph = junctionGraph(charGrid, slipperySlopes);
+    Visited visited;
+    return maximumPathFromGraph(graph, visited, { 1,0 }, { gridWidth(charGrid) - 2, gridHeight(charGrid) - 1 }, 0);
+}
+
+TEST(Aoc23Tests, sampleInput_longestHikeMatchesOldSearches) {
+    for (const bool slippery : { true, false }) {
+        ASSERT_EQ(cellByCell(sampleInput, slippery), doTheThing(sampleInput, slippery));
+        ASSERT_EQ(unorderedMapWalk(sampleInput, slippery), doTheThing(sampleInput, slippery));
+    }
+}
+
+TEST(Aoc23Tests, buildJunctionCsr_mergesParallelCorridors) {
+    // two ways round the block from the first junction to the second, both 9 long
+    cauto grid = parseGrid<char>(
+        "#.#######\n"
+        "#.......#\n"
+        "#.#####.#\n"
+        "#.#####.#\n"
+        "#.......#\n"
+        "#######.#\n");
+    cauto csr = buildJunctionCsr(grid, false);
+    ASSERT_EQ(4, csr.nodeCount());
+    ASSERT_EQ((std::vector<int32_t>{ 0, 1, 2, 4, 6 }), csr.offsets);
+    ASSERT_EQ(11, longestHike(compressGraph(csr), 1));
+}
+
+// a square lattice of corridors 2 apart, so every crossing is a junction bar two of the corners.
+// the maze is k*k junctions all told
+CharGrid latticeMaze(const int64_t k) {
+    auto grid = createGrid<char>(2 * k + 1, 2 * k + 1, '#');
+    for (int64_t y = 1; y < 2 * k; y++) {
+        for (int64_t x = 1; x < 2 * k; x++) {
+            grid[y][x] = (x % 2 == 1 || y % 2 == 1) ? '.' : '#';
+        }
+    }
+    grid[0][1] = '.';
+    grid[2 * k][2 * k - 1] = '.';
+    return grid;
+}
+
+TEST(Aoc23Tests, buildJunctionCsr_hugeMazeWithoutRecursion) {
+    constexpr int64_t k = 400;
+    cauto csr = buildJunctionCsr(latticeMaze(k), false);
+    ASSERT_EQ(k * k, csr.nodeCount());
+    // 2k(k-1) corridors between neighbouring crossings, the two plain corners each merge a pair of them,
+    // and there's one more in from the start and one out to the exit. All of them both ways
+    ASSERT_EQ(4 * k * (k - 1), std::ssize(csr.edges));
+}
+
+TEST(Aoc23Tests, compressGraph_rejectsWhatDoesntFit) {
+    ASSERT_EQ(64, compressGraph(buildJunctionCsr(latticeMaze(8), false)).nodeCount);
+    ASSERT_THROW(compressGraph(buildJunctionCsr(latticeMaze(9), false)), std::invalid_argument);
+    // a grid can't make one, but nothing stops a hand built one having a junction with five ways out
+    JunctionCsr star;
+    star.offsets = { 0, 1, 2, 7, 8, 9, 10, 11 };
+    star.edges = { { 2, 1 }, { 2, 1 }, { 0, 1 }, { 1, 1 }, { 3, 1 }, { 4, 1 }, { 5, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 } };
+    ASSERT_THROW(compressGraph(star), std::invalid_argument);
+}
+
 const std::string puzzleInput =
 R"(#.###########################################################################################################################################
 #.....###...#...#...#.......#...#.....###.....#...#...#...#.....###...#...###.......#.....#...#...#...###...................#...#...........#
@@ -443,11 +791,31 @@ TEST(Aoc23Tests, puzzleInput_doTheThing) {
     ASSERT_EQ(2166, doTheThing2(puzzleInput, true));
 }
 
+TEST(Aoc23Tests, puzzleInput_longestHikeMatchesOldSearches) {
+    ASSERT_EQ(cellByCell(puzzleInput, true), doTheThing(puzzleInput, true));
+    ASSERT_EQ(unorderedMapWalk(puzzleInput, true), doTheThing(puzzleInput, true));
+}
+
+
+TEST(Aoc23Tests, buildJunctionCsr_matchesNodify) {
+    for (cauto& input : { sampleInput, puzzleInput }) {
+        for (const bool slippery : { true, false }) {
+            ASSERT_EQ(unorderedMapWalk(input, slippery), longestHike(compressGraph(buildJunctionCsr(parseGrid<char>(input), slippery)), 1));
+        }
+    }
+}
+
+TEST(Aoc23Tests, puzzleInput_longestHike_sameForAnyThreadCount) {
+    cauto junctions = compressGraph(buildJunctionCsr(parseGrid<char>(puzzleInput), false));
+    cauto oneThread = longestHike(junctions, 1);
+    ASSERT_EQ(oneThread, longestHike(junctions, 3));
+    ASSERT_EQ(oneThread, longestHike(junctions, 16));
+}
 
 TEST(Aoc23Tests, puzzleInput_doTheThing2) {
     // 4999 is too low
     // 5009 wrong
     // 5010 wrong
     // 5011 wrong   
-    ASSERT_EQ(0, doTheThing2(puzzleInput, false));
+    ASSERT_EQ(6378, doTheThing2(puzzleInput, false));
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-23-test.cpp"
+
+#include "aoc-bench.h"
+
+// no synthetic sizes: a tiled maze doesn't have a single way in and out, and longest path
+// grows exponentially with the junction count anyway, so 10x the maze is not 10x the work
+void aoc_bench::registerDay() {
+	add("day23/doTheThing/sample", [] { return doTheThing(sampleInput, true); });
+	add("day23/doTheThing2/sample", [] { return doTheThing2(sampleInput, true); });
+	add("day23/doTheThing2/sampleNotSlippery", [] { return doTheThing2(sampleInput, false); });
+	add("day23/doTheThing/puzzle", [] { return doTheThing(puzzleInput, true); });
+	add("day23/doTheThing2/puzzle", [] { return doTheThing2(puzzleInput, true); });
+	add("day23/doTheThing2/puzzleNotSlippery", [] { return doTheThing2(puzzleInput, false); });
+
+	// only the graph building, on a maze with 10^5 junctions
+	cauto lattice = latticeMaze(400);
+	add("day23/buildJunctionCsr/lattice400", [lattice] { return buildJunctionCsr(lattice, false).edges.size(); });
+
+	// just the search, 1 thread up to every core, doubling
+	cauto junctions = compressGraph(buildJunctionCsr(parseGrid<char>(puzzleInput), false));
+	cauto cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned threads = 1; threads <= cores; threads = (threads * 2 > cores && threads < cores) ? cores : threads * 2) {
+		add("day23/longestHike/puzzleNotSlippery/threads:" + std::to_string(threads), [junctions, threads] { return longestHike(junctions, threads); });
+	}
+}
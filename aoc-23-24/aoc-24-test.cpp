@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
 #include <optional>
+#include <thread>
 
 #include "pex.h"
 
@@ -18,16 +23,25 @@ using Hailstones = std::vector<Hailstone>;
 
 Hailstones parseInput(const std::string& input, const double rebase) {
     Hailstones hailstones;
-    cauto lines = pSplit(input, '\n');
-    for (cauto& line : lines) {
+    for (cauto& line : pSplitView(input, '\n')) {
         Hailstone hailstone;
-        int result = sscanf_s(line.c_str(), "%lf, %lf, %lf @ %lf, %lf, %lf",
+        // the line's a view into input, not a null terminated string, so sscanf is out
+        std::array<double*, 6> fields = {
             &hailstone.position.x,
             &hailstone.position.y,
             &hailstone.position.z,
             &hailstone.velocity.x,
             &hailstone.velocity.y,
-            &hailstone.velocity.z);
+            &hailstone.velocity.z };
+        cauto lineEnd = line.data() + line.size();
+        auto cursor = line.data();
+        int result = 0;
+        for (auto field : fields) {
+            cursor = std::find_if(cursor, lineEnd, [](const char c) { return c == '-' || (c >= '0' && c <= '9'); });
+            cauto [next, error] = std::from_chars(cursor, lineEnd, *field);
+            result += (error == std::errc()) ? 1 : 0;
+            cursor = next;
+        }
         assert(result == 6);
         hailstone.position.x += rebase;
         hailstone.position.y += rebase;
@@ -97,7 +111,9 @@ std::optional<Vec3d> xyIntersection(const Vec3d& a, const Vec3d& b, const Vec3d&
     return rayRayXYIntersection(a, b, c, d);
 }
 
-int64_t doTheThing(const std::string& input, const double lowBound, const double highBound, const double rebase) {
+// the double version, kept to compare against. rebase pulls the positions in towards 0 so there's
+// some precision left over for the fractions, but it's still not exact
+int64_t approxCrossings(const std::string& input, const double lowBound, const double highBound, const double rebase) {
     cauto hailstones = parseInput(input, rebase);
     int sum = 0;
     for (auto hailstoneAIt = hailstones.begin(); hailstoneAIt != hailstones.end(); ++hailstoneAIt) {
@@ -123,6 +139,181 @@ int64_t doTheThing(const std::string& input, const double lowBound, const double
 }
 
 
+// 128 bit products for the bounds test, which is the one place 64 bits runs out: a position
+// (~2^49) times a determinant (~2^21), plus a velocity (~2^10) times a time numerator (~2^61)
+#ifdef __SIZEOF_INT128__
+using Wide = __int128;
+
+inline Wide wideMul(const int64_t a, const int64_t b) {
+    return static_cast<Wide>(a) * b;
+}
+#else
+// no __int128 on MSVC, so two's complement over a pair of uint64_t with just what the kernel uses
+struct Wide {
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+
+    Wide() = default;
+    Wide(const int64_t v) : lo(static_cast<uint64_t>(v)), hi(v < 0 ? ~uint64_t(0) : 0) {}
+    Wide(const uint64_t l, const uint64_t h) : lo(l), hi(h) {}
+
+    Wide operator+(const Wide& w) const {
+        cauto sumLo = lo + w.lo;
+        return { sumLo, hi + w.hi + (sumLo < lo ? 1 : 0) };
+    }
+    Wide operator-() const {
+        return Wide{ ~lo, ~hi } + Wide(int64_t(1));
+    }
+    Wide operator-(const Wide& w) const { return *this + -w; }
+    bool operator<(const Wide& w) const {
+        return (hi != w.hi) ? static_cast<int64_t>(hi) < static_cast<int64_t>(w.hi) : lo < w.lo;
+    }
+    bool operator<=(const Wide& w) const { return !(w < *this); }
+    bool operator>=(const Wide& w) const { return !(*this < w); }
+};
+
+inline Wide wideMul(const int64_t a, const int64_t b) {
+    // |a| * |b| from 32 bit halves, then the sign put back
+    cauto ua = (a < 0) ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+    cauto ub = (b < 0) ? 0 - static_cast<uint64_t>(b) : static_cast<uint64_t>(b);
+    cauto aLo = ua & 0xffffffff;
+    cauto aHi = ua >> 32;
+    cauto bLo = ub & 0xffffffff;
+    cauto bHi = ub >> 32;
+    cauto lolo = aLo * bLo;
+    cauto mid1 = aHi * bLo;
+    cauto mid2 = aLo * bHi;
+    cauto carry = ((lolo >> 32) + (mid1 & 0xffffffff) + (mid2 & 0xffffffff)) >> 32;
+    const Wide product{ lolo + (mid1 << 32) + (mid2 << 32), aHi * bHi + (mid1 >> 32) + (mid2 >> 32) + carry };
+    return ((a < 0) != (b < 0)) ? -product : product;
+}
+#endif
+
+// The hailstones a column per coordinate, positions already measured from the low corner of the
+// test area so everything after parsing is integers and nothing needs rebasing. Only x and y - part
+// 1 never looks at z.
+struct HailColumns {
+    std::vector<int64_t> px;
+    std::vector<int64_t> py;
+    std::vector<int64_t> vx;
+    std::vector<int64_t> vy;
+
+    size_t size() const { return px.size(); }
+};
+
+HailColumns parseColumns(const std::string& input, const int64_t lowBound) {
+    HailColumns columns;
+    for (cauto& line : pSplitView(input, '\n')) {
+        std::array<int64_t, 6> fields{};
+        cauto lineEnd = line.data() + line.size();
+        auto cursor = line.data();
+        int result = 0;
+        for (auto& field : fields) {
+            cursor = std::find_if(cursor, lineEnd, [](const char c) { return c == '-' || (c >= '0' && c <= '9'); });
+            cauto [next, error] = std::from_chars(cursor, lineEnd, field);
+            result += (error == std::errc()) ? 1 : 0;
+            cursor = next;
+        }
+        assert(result == 6);
+        columns.px.push_back(fields[0] - lowBound);
+        columns.py.push_back(fields[1] - lowBound);
+        columns.vx.push_back(fields[3]);
+        columns.vy.push_back(fields[4]);
+    }
+    return columns;
+}
+
+// Whether the paths of hailstones a and b cross ahead of both of them, inside a square of side size
+// from the columns' origin. Same algebra as rayRayXYIntersection, except nothing is ever divided: the
+// times are numerators over det, made positive by flipping signs if det isn't, and the crossing point
+// is compared with the bounds after multiplying them by det too.
+inline bool crossesInside(const HailColumns& c, const size_t a, const size_t b, const int64_t size) {
+    int64_t det = c.vx[b] * c.vy[a] - c.vy[b] * c.vx[a];
+    if (det == 0) {
+        return false;  // parallel
+    }
+    cauto dx = c.px[b] - c.px[a];
+    cauto dy = c.py[b] - c.py[a];
+    int64_t timeA = dy * c.vx[b] - dx * c.vy[b];
+    int64_t timeB = dy * c.vx[a] - dx * c.vy[a];
+    if (det < 0) {
+        det = -det;
+        timeA = -timeA;
+        timeB = -timeB;
+    }
+    if (timeA <= 0 || timeB <= 0) {
+        return false;
+    }
+    // a's position at timeA / det, times det
+    cauto x = wideMul(c.px[a], det) + wideMul(c.vx[a], timeA);
+    cauto y = wideMul(c.py[a], det) + wideMul(c.vy[a], timeA);
+    cauto high = wideMul(size, det);
+    return x >= Wide(int64_t(0)) && x <= high && y >= Wide(int64_t(0)) && y <= high;
+}
+
+// The pairs split into square tiles of crossingTile hailstones by crossingTile: one tile's worth of
+// both hailstones' columns is 16KB, so both fit in L1 while every pair between them gets checked.
+// Only tiles on or above the diagonal are real, numbered row by row.
+constexpr size_t crossingTile = 256;
+
+// which tile (row, column) the k-th one on or above the diagonal is, out of blocks x blocks
+std::pair<size_t, size_t> tileAt(const size_t k, const size_t blocks) {
+    // row r starts at r * blocks - r * (r - 1) / 2, solve for r and then nudge it for rounding
+    cauto b = static_cast<double>(2 * blocks + 1);
+    auto row = static_cast<size_t>((b - std::sqrt(b * b - 8.0 * static_cast<double>(k))) / 2);
+    cauto rowStart = [blocks](const size_t r) { return r * blocks - r * (r - 1) / 2; };
+    for (; row > 0 && rowStart(row) > k; row--) {}
+    for (; row + 1 < blocks && rowStart(row + 1) <= k; row++) {}
+    return { row, row + k - rowStart(row) };
+}
+
+int64_t countTileCrossings(const HailColumns& columns, const int64_t size, const size_t row, const size_t col, const size_t tile) {
+    int64_t count = 0;
+    cauto aEnd = std::min(columns.size(), (row + 1) * tile);
+    cauto bEnd = std::min(columns.size(), (col + 1) * tile);
+    for (size_t a = row * tile; a < aEnd; a++) {
+        for (size_t b = std::max(a + 1, col * tile); b < bEnd; b++) {
+            count += crossesInside(columns, a, b, size) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// tiles are handed out one at a time off a shared counter, the ones by the diagonal are half empty.
+// Each thread counts into its own total and they're only added up at the end
+int64_t countCrossings(const HailColumns& columns, const int64_t size,
+    const unsigned requestedThreads = std::max(1u, std::thread::hardware_concurrency()), const size_t requestedTile = crossingTile) {
+    // 0 of either means the least there can be, rather than no counts to write to or a divide by 0
+    cauto threads = std::max(1u, requestedThreads);
+    cauto tile = std::max<size_t>(1, requestedTile);
+    cauto blocks = (columns.size() + tile - 1) / tile;
+    cauto tiles = static_cast<int64_t>(blocks * (blocks + 1) / 2);
+    std::atomic<int64_t> nextTile = 0;
+    std::vector<int64_t> counts(threads, 0);
+    const auto work = [&](const unsigned t) {
+        int64_t count = 0;
+        for (auto k = nextTile++; k < tiles; k = nextTile++) {
+            cauto [row, col] = tileAt(static_cast<size_t>(k), blocks);
+            count += countTileCrossings(columns, size, row, col, tile);
+        }
+        counts[t] = count;
+    };
+    if (threads <= 1) {
+        work(0);
+    }
+    else {
+        std::vector<std::jthread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back(work, t);
+        }
+    }
+    return pReduce(counts);
+}
+
+int64_t doTheThing(const std::string& input, const int64_t lowBound, const int64_t highBound) {
+    return countCrossings(parseColumns(input, lowBound), highBound - lowBound);
+}
+
 TEST(Aoc24Tests, stones_intersection) {
     cauto result0 = xyIntersection(Vec3d(19, 13, 30), Vec3d(-2, 1, -2), Vec3d(18, 19, 22), Vec3d(-1, -1, -2));
     ASSERT_TRUE(approxEqual(Vec3d(14.333, 15.333), result0.value()));
@@ -171,7 +362,7 @@ R"(19, 13, 30 @ -2,  1, -2
 )";
 
 TEST(Aoc24Tests, sampleInput_doTheThing_2) {
-    ASSERT_EQ(2, doTheThing(sampleInput, 7, 27, -17));
+    ASSERT_EQ(2, doTheThing(sampleInput, 7, 27));
 }
 
 const std::string puzzleInput = 
@@ -480,6 +671,48 @@ R"(6263818263729, 154297393198398, 243751970387886 @ 193, 144, 129
 
 
 TEST(Aoc24Tests, puzzleInput_doTheThing) {
-    // 0 is not right :P
-    ASSERT_EQ(0, doTheThing(puzzleInput, 200000000000000, 400000000000000, -300000000000000));
+    ASSERT_EQ(13892, doTheThing(puzzleInput, 200000000000000, 400000000000000));
+}
+
+TEST(Aoc24Tests, countCrossings_matchesDoubles) {
+    ASSERT_EQ(approxCrossings(sampleInput, 7, 27, -17), doTheThing(sampleInput, 7, 27));
+    ASSERT_EQ(approxCrossings(puzzleInput, 200000000000000, 400000000000000, -300000000000000),
+        doTheThing(puzzleInput, 200000000000000, 400000000000000));
+}
+
+TEST(Aoc24Tests, crossesInside_edges) {
+    // crossing exactly on the boundary counts, crossing one past it doesn't. Both start 10 out
+    // along their own axis and head for the origin, so they cross at (0, 0) after 10 steps
+    const HailColumns corner{ { 10, 0 }, { 0, 10 }, { -1, 0 }, { 0, -1 } };
+    ASSERT_TRUE(crossesInside(corner, 0, 1, 5));
+    ASSERT_TRUE(crossesInside(corner, 1, 0, 5));
+    const HailColumns outside{ { 10, -1 }, { -1, 10 }, { -1, 0 }, { 0, -1 } };  // cross at (-1, -1)
+    ASSERT_FALSE(crossesInside(outside, 0, 1, 5));
+    const HailColumns past{ { 10, 0 }, { 0, 10 }, { 1, 0 }, { 0, -1 } };  // a's heading away
+    ASSERT_FALSE(crossesInside(past, 0, 1, 5));
+    // puzzle sized numbers landing exactly on the far corner, after 1000 steps for both
+    const int64_t far = 200000000000000;
+    const HailColumns corners{ { far - 1000, far - 3000 }, { far - 1000, far - 1000 }, { 1, 3 }, { 1, 1 } };
+    ASSERT_TRUE(crossesInside(corners, 0, 1, far));
+    ASSERT_FALSE(crossesInside(corners, 0, 1, far - 1));
+}
+
+TEST(Aoc24Tests, tileAt_everyTileOnce) {
+    for (const size_t blocks : { 1, 2, 3, 40, 1000 }) {
+        size_t k = 0;
+        for (size_t row = 0; row < blocks; row++) {
+            for (size_t col = row; col < blocks; col++, k++) {
+                ASSERT_EQ(std::make_pair(row, col), tileAt(k, blocks));
+            }
+        }
+    }
+}
+
+TEST(Aoc24Tests, countCrossings_sameForAnyThreadsAndTiles) {
+    cauto columns = parseColumns(puzzleInput, 200000000000000);
+    for (const unsigned threads : { 0, 1, 3, 16 }) {
+        for (const size_t tile : { 0, 1, 7, 256, 1000 }) {
+            ASSERT_EQ(13892, countCrossings(columns, 200000000000000, threads, tile));
+        }
+    }
 }
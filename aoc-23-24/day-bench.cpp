@@ -0,0 +1,38 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-24-test.cpp"
+
+#include "aoc-bench.h"
+
+// count hailstones in the same ballpark as the puzzle's. Repeating the real ones would
+// just make a lot of identical, parallel paths.
+std::string hailstorm(const int64_t count) {
+	aoc_bench::Lcg lcg;
+	std::string result;
+	for (int64_t i = 0; i < count; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			result += std::to_string(lcg.range(100000000000000, 500000000000000)) + (axis < 2 ? ", " : " @ ");
+		}
+		for (int axis = 0; axis < 3; axis++) {
+			result += std::to_string(lcg.range(-500, 500)) + (axis < 2 ? ", " : "\n");
+		}
+	}
+	return result;
+}
+
+void aoc_bench::registerDay() {
+	add("day24/doTheThing/sample", [] { return doTheThing(sampleInput, 7, 27); });
+	add("day24/doTheThing/puzzle", [] { return doTheThing(puzzleInput, 200000000000000, 400000000000000); });
+	add("day24/approxCrossings/puzzle", [] { return approxCrossings(puzzleInput, 200000000000000, 400000000000000, -300000000000000); });
+	// pairs only, the parsing's out of the way. 1 thread up to every core, doubling
+	const auto tenThousand = parseColumns(hailstorm(10000), 200000000000000);
+	const auto cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned threads = 1; threads <= cores; threads = (threads * 2 > cores && threads < cores) ? cores : threads * 2) {
+		add("day24/countCrossings/10k/threads:" + std::to_string(threads), [tenThousand, threads] { return countCrossings(tenThousand, 200000000000000, threads); });
+	}
+	const auto puzzleCount = std::ssize(lines(puzzleInput));
+	for (const auto& [scale, suffix] : scales) {
+		const auto scaled = hailstorm(puzzleCount * scale);
+		add(std::string("day24/doTheThing/") + suffix, [scaled] { return doTheThing(scaled, 200000000000000, 400000000000000); });
+	}
+}
@@ -17,14 +17,14 @@ using Vertex = std::pair<std::string, std::vector<std::string>>;
 using GraphInput = std::vector<Vertex>;
 
 GraphInput parseInput(const std::string input) {
-    cauto lines = pSplit(input, '\n');
     GraphInput graphInput;
-    for (cauto& line : lines) {
-        cauto words = pSplit(line, ' ');
-        std::string vertex0name = words[0].substr(0, 3);
+    for (cauto& line : pSplitView(input, '\n')) {
+        cauto words = pSplitView(line, ' ');
+        auto word = words.begin();
+        std::string vertex0name(word->substr(0, 3));
         Vertex vertex{ vertex0name, {} };
-        for (int i = 1; i < words.size(); i++) {
-            vertex.second.emplace_back(words[i]);
+        for (++word; word != words.end(); ++word) {
+            vertex.second.emplace_back(*word);
         }
         graphInput.emplace_back(vertex);
     }
@@ -0,0 +1,11 @@
+// benchmarks for aoc-bench, see bench/aoc-bench.h
+
+#include "aoc-25-test.cpp"
+
+#include "aoc-bench.h"
+
+// no synthetic sizes, there's no honest way to grow a graph and keep it a 3-edge cut
+void aoc_bench::registerDay() {
+	add("day25/doTheThing/sample", [] { return quietly([] { return doTheThing(sampleInput); }); });
+	add("day25/doTheThing/puzzle", [] { return quietly([] { return doTheThing(parseInput(puzzleInput)); }); });
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+// shared bits for the per-day benchmark executables. Each day's day-bench.cpp #includes that day's
+// test cpp (so every doTheThing and every embedded input is right there), defines registerDay()
+// and links against bench-main.cpp, which owns main() and the counting operator new.
+// The days can't share one binary - they each bring their own pex.h and their own doTheThing.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace aoc_bench {
+
+	struct AllocStats {
+		int64_t allocations = 0;
+		int64_t bytes = 0;
+	};
+
+	// running totals from the global operator new in bench-main.cpp
+	AllocStats allocStats();
+
+	// high water mark of the whole process so far, in bytes
+	int64_t peakRssBytes();
+
+	// the day fills this in, main() calls it before running anything
+	void registerDay();
+
+	// registers func() as "name" and reports per-op allocation counts/bytes and the process peak RSS
+	// alongside the usual ns/op. The result goes through DoNotOptimize so the work can't be thrown away.
+	template <typename Func>
+	void add(const std::string& name, Func func) {
+		benchmark::RegisterBenchmark(name.c_str(), [func](benchmark::State& state) {
+			const AllocStats before = allocStats();
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(func());
+			}
+			const AllocStats after = allocStats();
+			state.counters["allocs/op"] = benchmark::Counter(static_cast<double>(after.allocations - before.allocations), benchmark::Counter::kAvgIterations);
+			state.counters["bytes/op"] = benchmark::Counter(static_cast<double>(after.bytes - before.bytes), benchmark::Counter::kAvgIterations, benchmark::Counter::OneK::kIs1024);
+			state.counters["peakRSS"] = benchmark::Counter(static_cast<double>(peakRssBytes()), benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+		})->Unit(benchmark::kMicrosecond);
+	}
+
+	// for the days that print their working as they go, so the report isn't buried under it
+	template <typename Func>
+	auto quietly(Func func) {
+		std::cout.setstate(std::ios::badbit);
+		const auto result = func();
+		std::cout.clear();
+		return result;
+	}
+
+	// synthetic inputs: the real inputs are all small, so these blow them up to ~10x/100x to see
+	// how the hot paths scale rather than how fast a puzzle-sized answer comes back.
+	inline constexpr std::pair<int, const char*> scales[] = { { 10, "x10" }, { 100, "x100" } };
+
+	// smallest k with k*k >= scale, for growing a grid in both directions
+	inline int tilesFor(const int scale) {
+		int k = 1;
+		for (; k * k < scale; k++) {}
+		return k;
+	}
+
+	std::vector<std::string_view> lines(std::string_view input);
+
+	// the grid repeated tilesX across and tilesY down, newline-terminated rows, '\r' dropped
+	std::string tileGrid(std::string_view input, int tilesX, int tilesY);
+
+	// input written out count times with sep between the copies, e.g. "a,b," x3 -> "a,b,a,b,a,b".
+	// trailing separator characters are dropped first, no trailing sep on the result either
+	std::string repeatRecords(std::string_view input, std::string_view sep, int count);
+
+	template <typename T>
+	std::vector<T> repeatVector(const std::vector<T>& input, const int count) {
+		std::vector<T> result;
+		result.reserve(input.size() * count);
+		for (int i = 0; i < count; i++) {
+			result.insert(result.end(), input.begin(), input.end());
+		}
+		return result;
+	}
+
+	// same LCG the grid and split benches use, so synthetic data is the same on every run
+	struct Lcg {
+		uint32_t seed = 12345;
+		uint32_t next() {
+			seed = seed * 1664525u + 1013904223u;
+			return seed;
+		}
+		// roughly uniform in [lo, hi)
+		int64_t range(const int64_t lo, const int64_t hi) {
+			const uint64_t wide = (static_cast<uint64_t>(next()) << 32) | next();
+			return lo + static_cast<int64_t>(wide % static_cast<uint64_t>(hi - lo));
+		}
+	};
+}
@@ -0,0 +1,150 @@
+// main() for every aoc-NN-bench executable, plus the allocation counting and peak RSS lookups
+// that aoc-bench.h promises. Linked once per day next to that day's day-bench.cpp.
+
+#include "aoc-bench.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+	std::atomic<int64_t> allocationCount{ 0 };
+	std::atomic<int64_t> allocatedBytes{ 0 };
+
+	void* countedAlloc(const std::size_t size) {
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+		if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+		throw std::bad_alloc();
+	}
+
+	// Grid's cell buffers come through here, so these have to be counted too
+	void* countedAlignedAlloc(const std::size_t size, const std::align_val_t alignment) {
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+		const auto align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+		if (void* ptr = _aligned_malloc(size ? size : 1, align)) return ptr;
+#else
+		// aligned_alloc wants the size to be a multiple of the alignment
+		if (void* ptr = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align)) return ptr;
+#endif
+		throw std::bad_alloc();
+	}
+
+	void alignedFree(void* ptr) {
+#ifdef _WIN32
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	try { return countedAlignedAlloc(size, alignment); } catch (const std::bad_alloc&) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	try { return countedAlignedAlloc(size, alignment); } catch (const std::bad_alloc&) { return nullptr; }
+}
+void operator delete(void* ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(ptr); }
+
+namespace aoc_bench {
+
+	AllocStats allocStats() {
+		return { allocationCount.load(std::memory_order_relaxed), allocatedBytes.load(std::memory_order_relaxed) };
+	}
+
+	int64_t peakRssBytes() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return static_cast<int64_t>(counters.PeakWorkingSetSize);
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return static_cast<int64_t>(usage.ru_maxrss);
+#else
+		return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+	}
+
+	std::vector<std::string_view> lines(std::string_view input) {
+		std::vector<std::string_view> result;
+		while (!input.empty()) {
+			const auto end = input.find('\n');
+			auto line = input.substr(0, end);
+			if (!line.empty() && line.back() == '\r') {
+				line.remove_suffix(1);
+			}
+			result.push_back(line);
+			input = (end == std::string_view::npos) ? std::string_view() : input.substr(end + 1);
+		}
+		return result;
+	}
+
+	std::string tileGrid(const std::string_view input, const int tilesX, const int tilesY) {
+		const auto rows = lines(input);
+		std::string result;
+		result.reserve(input.size() * tilesX * tilesY + rows.size() * tilesY);
+		for (int ty = 0; ty < tilesY; ty++) {
+			for (const auto row : rows) {
+				for (int tx = 0; tx < tilesX; tx++) {
+					result += row;
+				}
+				result += '\n';
+			}
+		}
+		return result;
+	}
+
+	std::string repeatRecords(std::string_view input, const std::string_view sep, const int count) {
+		// anything separator-ish left on the end would turn into empty records between the copies
+		while (!input.empty() && (input.back() == '\r' || sep.find(input.back()) != std::string_view::npos)) {
+			input.remove_suffix(1);
+		}
+		std::string result;
+		result.reserve((input.size() + sep.size()) * count);
+		for (int i = 0; i < count; i++) {
+			if (i > 0) {
+				result += sep;
+			}
+			result += input;
+		}
+		return result;
+	}
+}
+
+int main(int argc, char** argv) {
+	aoc_bench::registerDay();
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}